@@ -0,0 +1,611 @@
+// 多线程 epoll 压测工具, 支持 keep-alive、pipelining、固定速率 (开环) 模式和 URL 混合文件,
+// 延迟用 HDR 风格的对数-线性直方图统计, 输出 p50/p90/p99/p99.9
+//   ./loadgen -c 100 -t 4 -d 10 http://127.0.0.1:8080/            # 闭环, 每个连接一个在途请求
+//   ./loadgen -c 100 -t 4 -p 16 http://127.0.0.1:8080/             # 每个连接 16 个 pipelined 请求
+//   ./loadgen -c 100 -t 4 -R 20000 http://127.0.0.1:8080/          # 开环, 总速率 20000 req/s
+//   ./loadgen -c 100 -f mix.txt http://127.0.0.1:8080              # 按权重混合请求, 见 bench/mix.txt
+//   ./loadgen -C -c 50 http://127.0.0.1:8080/                       # 每个请求新建连接 (Connection: close)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// HDR 风格的延迟直方图: 每个 2 的幂区间再等分为 SUB_COUNT 个桶, 相对误差不超过 1 / SUB_COUNT,
+// 记录 O(1), 不需要保存每个样本, 各线程的直方图最后合并
+class Histogram {
+public:
+    Histogram() : counts_((64 - SUB_BITS + 1) * SUB_COUNT, 0) {}
+
+    void record(int64_t value) {
+        if (value < 0) value = 0;
+        ++ counts_[indexOf(static_cast<uint64_t>(value))];
+        ++ total_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < counts_.size(); ++ i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    // 返回不小于 q 比例样本的最小桶的上界
+    int64_t percentile(double q) const {
+        if (total_ == 0) return 0;
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(q * total_ + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++ i) {
+            seen += counts_[i];
+            if (seen >= target) return std::min<int64_t>(upperBound(i), max_);
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return total_; }
+    int64_t min() const { return total_ ? min_ : 0; }
+    int64_t max() const { return max_; }
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0; }
+
+private:
+    static constexpr int SUB_BITS = 7;
+    static constexpr uint64_t SUB_COUNT = 1u << SUB_BITS;
+
+    static size_t indexOf(uint64_t v) {
+        if (v < SUB_COUNT) return v;
+        int shift = 63 - __builtin_clzll(v) - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + ((v >> shift) - SUB_COUNT);
+    }
+
+    static int64_t upperBound(size_t index) {
+        size_t bucket = index / SUB_COUNT;
+        uint64_t sub = index % SUB_COUNT;
+        if (bucket == 0) return sub;
+        return static_cast<int64_t>(((SUB_COUNT + sub + 1) << (bucket - 1)) - 1);
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    int64_t sum_ = 0;
+    int64_t min_ = INT64_MAX;
+    int64_t max_ = 0;
+};
+
+struct Options {
+    int connections = 50;
+    int threads = 1;
+    int duration = 10;  // 秒
+    int pipeline = 1;  // 每个连接最多在途的请求数
+    double rate = 0;  // 开环模式的总速率 (req/s), 0 表示闭环
+    bool keep_alive = true;
+    std::string host = "127.0.0.1";
+    std::string port = "80";
+    std::string path = "/";
+    const char* mix_file = nullptr;
+};
+
+// 预先拼好的请求报文, 按权重随机选择
+struct RequestMix {
+    std::vector<std::string> requests;
+    std::vector<uint64_t> cumulative;  // 权重前缀和
+
+    void add(const std::string& raw, uint64_t weight) {
+        requests.push_back(raw);
+        cumulative.push_back((cumulative.empty() ? 0 : cumulative.back()) + weight);
+    }
+
+    const std::string& pick(uint64_t random) const {
+        if (requests.size() == 1) return requests[0];
+        uint64_t r = random % cumulative.back();
+        size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin();
+        return requests[i];
+    }
+};
+
+static std::string buildRequest(const Options& options, const std::string& method, const std::string& path, const std::string& body) {
+    std::string raw = method + " " + path + " HTTP/1.1\r\nHost: " + options.host + ":" + options.port + "\r\n";
+    raw += options.keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    if (method == "POST") {
+        raw += "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    return raw + "\r\n" + body;
+}
+
+// 每行 "[权重] [方法] 路径 [body]", 权重默认为 1, 方法默认为 GET, # 开头为注释
+static bool loadMix(const Options& options, const char* filename, RequestMix& mix) {
+    std::ifstream in(filename);
+    if (!in) {
+        perror(filename);
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string token, method = "GET", path, body;
+        uint64_t weight = 1;
+        if (!(fields >> token) || token[0] == '#') continue;
+        if (isdigit(static_cast<unsigned char>(token[0]))) {
+            weight = std::strtoull(token.c_str(), nullptr, 10);
+            if (!(fields >> token)) continue;
+        }
+        if (token[0] != '/') {
+            method = token;
+            if (!(fields >> token)) continue;
+        }
+        path = token;
+        fields >> body;
+        if (weight > 0) mix.add(buildRequest(options, method, path, body), weight);
+    }
+    if (mix.requests.empty()) {
+        fprintf(stderr, "%s: no requests\n", filename);
+        return false;
+    }
+    return true;
+}
+
+struct Stats {
+    uint64_t responses = 0;
+    uint64_t bytes = 0;
+    uint64_t connect_errors = 0;
+    uint64_t io_errors = 0;  // 读写出错或在途请求所在的连接被关闭
+    uint64_t status[6] = {};  // 按状态码的首位统计, status[2] 为 2xx
+    uint64_t backlog_max = 0;  // 开环模式下因连接全部占满而排队的最大请求数
+    Histogram latency;  // ns
+};
+
+// 一个线程负责一组连接, 所有连接注册在同一个 epoll 中
+class Worker {
+public:
+    Worker(const Options& options, const RequestMix& mix, const sockaddr_storage& addr, socklen_t addr_len, int connections, uint64_t seed)
+        : options_(options), mix_(mix), addr_(addr), addr_len_(addr_len), conns_(connections), rng_(seed | 1) {
+        if (options_.rate > 0) interval_ns_ = 1e9 * options_.threads / options_.rate;
+    }
+
+    void run(const std::atomic<bool>& stop);
+    Stats& stats() { return stats_; }
+
+private:
+    struct Conn {
+        int fd = -1;
+        bool connected = false;
+        std::string out;  // 待发送的数据
+        size_t out_off = 0;
+        std::string in;  // 尚未解析的响应数据
+        std::deque<int64_t> sent;  // 在途请求的开始时间, 开环模式下为计划发送时间
+        size_t body_left = 0;  // 当前响应还没收到的 body 字节数
+        bool in_body = false;
+        bool close_after = false;  // 当前响应带有 Connection: close
+        int status = 0;
+    };
+
+    uint64_t random() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 7;
+        rng_ ^= rng_ << 17;
+        return rng_;
+    }
+
+    void connectAll();
+    void connect(size_t i);
+    void reset(size_t i, bool error);
+    void enqueue(size_t i, int64_t start);
+    void fill(size_t i, int64_t now);
+    void dispatchBacklog();
+    int wait(std::vector<epoll_event>& events, int64_t timeout_ns);
+    bool flush(size_t i);
+    bool receive(size_t i);
+    bool parse(size_t i, bool& replaced);
+    bool complete(size_t i);
+
+    const Options& options_;
+    const RequestMix& mix_;
+    sockaddr_storage addr_;
+    socklen_t addr_len_;
+    std::vector<Conn> conns_;
+    int epoll_fd_ = -1;
+    uint64_t rng_;
+    bool stopping_ = false;
+    Stats stats_;
+
+    // 开环模式
+    double interval_ns_ = 0;  // 本线程相邻两个请求的计划间隔
+    double next_send_ns_ = 0;
+    std::deque<int64_t> backlog_;  // 已到计划时间但还没有空闲连接的请求
+    size_t next_conn_ = 0;
+};
+
+void Worker::connect(size_t i) {
+    Conn& conn = conns_[i];
+    conn = Conn();
+    conn.fd = socket(addr_.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn.fd == -1) {
+        ++ stats_.connect_errors;
+        return;
+    }
+    int one = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(conn.fd, reinterpret_cast<const sockaddr*>(&addr_), addr_len_) == -1 && errno != EINPROGRESS) {
+        ++ stats_.connect_errors;
+        close(conn.fd);
+        conn.fd = -1;
+        return;
+    }
+    epoll_event event{};
+    event.data.u64 = i;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn.fd, &event);
+}
+
+void Worker::connectAll() {
+    for (size_t i = 0; i < conns_.size(); ++ i) connect(i);
+}
+
+// 关闭连接并重新建立, 在途的请求在开环模式下放回队列重发, 闭环模式下直接丢弃
+void Worker::reset(size_t i, bool error) {
+    Conn& conn = conns_[i];
+    if (conn.fd != -1) close(conn.fd);  // close 会自动从 epoll 中移除
+    if (error) {
+        if (!conn.connected) {
+            ++ stats_.connect_errors;
+        } else {
+            stats_.io_errors += std::max<size_t>(1, conn.sent.size());
+        }
+    }
+    std::deque<int64_t> unsent;
+    if (interval_ns_ > 0) unsent.swap(conn.sent);
+    conn.fd = -1;
+    if (stopping_) return;
+    connect(i);
+    for (auto it = unsent.rbegin(); it != unsent.rend(); ++ it) backlog_.push_front(*it);
+}
+
+void Worker::enqueue(size_t i, int64_t start) {
+    Conn& conn = conns_[i];
+    conn.out += mix_.pick(random());
+    conn.sent.push_back(start);
+}
+
+// 闭环模式: 补满 pipeline
+void Worker::fill(size_t i, int64_t now) {
+    Conn& conn = conns_[i];
+    size_t depth = options_.keep_alive ? options_.pipeline : 1;
+    while (conn.sent.size() < depth) enqueue(i, now);
+}
+
+// 开环模式: 把排队的请求分给还有空位的连接
+void Worker::dispatchBacklog() {
+    size_t depth = options_.keep_alive ? options_.pipeline : 1;
+    for (size_t tried = 0; !backlog_.empty() && tried < conns_.size(); ++ tried) {
+        size_t i = next_conn_;
+        next_conn_ = (next_conn_ + 1) % conns_.size();
+        Conn& conn = conns_[i];
+        if (conn.fd == -1 || !conn.connected) continue;
+        bool added = false;
+        while (!backlog_.empty() && conn.sent.size() < depth) {
+            enqueue(i, backlog_.front());
+            backlog_.pop_front();
+            added = true;
+        }
+        if (added && !flush(i)) reset(i, true);
+    }
+    stats_.backlog_max = std::max<uint64_t>(stats_.backlog_max, backlog_.size());
+}
+
+bool Worker::flush(size_t i) {
+    Conn& conn = conns_[i];
+    while (conn.out_off < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.out_off, conn.out.size() - conn.out_off, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.out_off += n;
+            continue;
+        }
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;
+    }
+    conn.out.clear();
+    conn.out_off = 0;
+    return true;
+}
+
+bool Worker::receive(size_t i) {
+    Conn& conn = conns_[i];
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t n = recv(conn.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            stats_.bytes += n;
+            // body 不需要保存, 直接跳过
+            size_t off = 0;
+            if (conn.in_body && conn.in.empty()) {
+                off = std::min(conn.body_left, static_cast<size_t>(n));
+                conn.body_left -= off;
+            }
+            conn.in.append(buf + off, n - off);
+            bool replaced = false;
+            if (!parse(i, replaced)) return false;
+            if (replaced) return true;  // Connection: close, 已经换成了新的连接
+            continue;
+        }
+        if (n == 0) return false;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+// 解析 in 中所有完整的响应, 只支持 Content-Length (服务器不使用分块编码)
+bool Worker::parse(size_t i, bool& replaced) {
+    Conn& conn = conns_[i];
+    size_t pos = 0;
+    while (true) {
+        if (conn.in_body) {
+            size_t take = std::min(conn.body_left, conn.in.size() - pos);
+            pos += take;
+            conn.body_left -= take;
+            if (conn.body_left > 0) break;
+            conn.in_body = false;
+            if (!complete(i)) {
+                replaced = true;
+                return true;
+            }
+            continue;
+        }
+        size_t end = conn.in.find("\r\n\r\n", pos);
+        if (end == std::string::npos) break;
+        if (conn.in.compare(pos, 5, "HTTP/") != 0 || conn.sent.empty()) return false;
+        conn.status = atoi(conn.in.c_str() + pos + 9);
+        conn.body_left = 0;
+        conn.close_after = !options_.keep_alive;
+        // 逐行查找需要的 header, 名称大小写不敏感
+        size_t line = conn.in.find("\r\n", pos) + 2;
+        while (line < end) {
+            size_t line_end = conn.in.find("\r\n", line);
+            const char* p = conn.in.c_str() + line;
+            if (strncasecmp(p, "Content-Length:", 15) == 0) {
+                conn.body_left = std::strtoull(p + 15, nullptr, 10);
+            } else if (strncasecmp(p, "Connection:", 11) == 0 && strstr(std::string(p + 11, line_end - line - 11).c_str(), "close")) {
+                conn.close_after = true;
+            }
+            line = line_end + 2;
+        }
+        pos = end + 4;
+        conn.in_body = true;
+    }
+    conn.in.erase(0, pos);
+    return true;
+}
+
+// 返回 false 表示连接已被关闭并重新建立
+bool Worker::complete(size_t i) {
+    Conn& conn = conns_[i];
+    int64_t now = nowNs();
+    ++ stats_.responses;
+    ++ stats_.status[std::min(conn.status / 100, 5)];
+    stats_.latency.record(now - conn.sent.front());
+    conn.sent.pop_front();
+
+    if (conn.close_after) {
+        reset(i, !conn.sent.empty());
+        if (interval_ns_ == 0 && conn.fd != -1) fill(i, now);
+        return false;
+    }
+    if (interval_ns_ > 0) {
+        dispatchBacklog();
+    } else {
+        fill(i, now);
+    }
+    return true;
+}
+
+// 开环模式的请求间隔常常小于 1 ms, epoll_pwait2 可以精确地睡到下一个计划时间, 不需要忙等;
+// 内核不支持时退回 epoll_wait, 超时向上取整到 ms
+int Worker::wait(std::vector<epoll_event>& events, int64_t timeout_ns) {
+    static bool has_pwait2 = true;
+    if (has_pwait2) {
+        timespec ts{static_cast<time_t>(timeout_ns / 1000000000), static_cast<long>(timeout_ns % 1000000000)};
+        int n = epoll_pwait2(epoll_fd_, events.data(), events.size(), &ts, nullptr);
+        if (n != -1 || errno != ENOSYS) return n;
+        has_pwait2 = false;
+    }
+    return epoll_wait(epoll_fd_, events.data(), events.size(), static_cast<int>((timeout_ns + 999999) / 1000000));
+}
+
+void Worker::run(const std::atomic<bool>& stop) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    connectAll();
+    int64_t start = nowNs();
+    next_send_ns_ = start;
+    if (interval_ns_ == 0) {
+        for (size_t i = 0; i < conns_.size(); ++ i) {
+            if (conns_[i].fd != -1) fill(i, start);
+        }
+    }
+
+    std::vector<epoll_event> events(conns_.size() + 1);
+    while (!stop.load(std::memory_order_relaxed)) {
+        int64_t wait_ns = 100 * 1000 * 1000;
+        if (interval_ns_ > 0) wait_ns = std::max<int64_t>(0, static_cast<int64_t>(next_send_ns_) - nowNs());
+        int nfds = wait(events, wait_ns);
+        for (int k = 0; k < nfds; ++ k) {
+            size_t i = events[k].data.u64;
+            Conn& conn = conns_[i];
+            if (conn.fd == -1) continue;
+            if (events[k].events & (EPOLLERR | EPOLLHUP) && !conn.connected) {
+                reset(i, true);
+                continue;
+            }
+            conn.connected = true;
+            if ((events[k].events & EPOLLIN) && !receive(i)) {
+                reset(i, true);
+                if (interval_ns_ == 0) fill(i, nowNs());
+                continue;
+            }
+            if (!flush(i)) {
+                reset(i, true);
+                if (interval_ns_ == 0) fill(i, nowNs());
+            }
+        }
+
+        // 开环模式: 按计划时间产生请求, 与服务器响应快慢无关, 延迟从计划时间开始计算
+        if (interval_ns_ > 0) {
+            int64_t now = nowNs();
+            while (next_send_ns_ <= now) {
+                backlog_.push_back(static_cast<int64_t>(next_send_ns_));
+                next_send_ns_ += interval_ns_;
+            }
+            dispatchBacklog();
+        }
+        // 重试建立失败的连接
+        for (size_t i = 0; i < conns_.size(); ++ i) {
+            if (conns_[i].fd == -1) {
+                connect(i);
+                if (interval_ns_ == 0 && conns_[i].fd != -1) fill(i, nowNs());
+            }
+        }
+    }
+    stopping_ = true;
+    for (Conn& conn: conns_) {
+        if (conn.fd != -1) close(conn.fd);
+    }
+    close(epoll_fd_);
+}
+
+static bool parseUrl(const char* url, Options& options) {
+    std::string s = url;
+    if (s.compare(0, 7, "http://") == 0) s = s.substr(7);
+    size_t slash = s.find('/');
+    std::string authority = s.substr(0, slash);
+    options.path = slash == std::string::npos ? "/" : s.substr(slash);
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos) {
+        options.host = authority.substr(0, colon);
+        options.port = authority.substr(colon + 1);
+    } else {
+        options.host = authority;
+    }
+    return !options.host.empty();
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-c connections] [-t threads] [-d seconds] [-p depth] [-R rate] [-f mix] [-C] url\n"
+                    "  -c  连接数, 默认 50\n"
+                    "  -t  线程数, 默认 1\n"
+                    "  -d  持续时间 (秒), 默认 10\n"
+                    "  -p  每个连接 pipelined 的在途请求数, 默认 1\n"
+                    "  -R  开环模式, 按固定总速率 (req/s) 发送请求, 延迟从计划发送时间算起\n"
+                    "  -f  URL 混合文件, 每行 \"[权重] [方法] 路径 [body]\"\n"
+                    "  -C  不使用 keep-alive, 每个请求新建连接\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:t:d:p:R:f:Ch")) != -1) {
+        switch (opt) {
+            case 'c': options.connections = std::max(1, atoi(optarg)); break;
+            case 't': options.threads = std::max(1, atoi(optarg)); break;
+            case 'd': options.duration = std::max(1, atoi(optarg)); break;
+            case 'p': options.pipeline = std::max(1, atoi(optarg)); break;
+            case 'R': options.rate = atof(optarg); break;
+            case 'f': options.mix_file = optarg; break;
+            case 'C': options.keep_alive = false; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc || !parseUrl(argv[optind], options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    options.threads = std::min(options.threads, options.connections);
+
+    addrinfo hints{}, *result = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int rc = getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &result);
+    if (rc != 0) {
+        fprintf(stderr, "%s: %s\n", options.host.c_str(), gai_strerror(rc));
+        return 1;
+    }
+    sockaddr_storage addr{};
+    socklen_t addr_len = result->ai_addrlen;
+    memcpy(&addr, result->ai_addr, addr_len);
+    freeaddrinfo(result);
+
+    RequestMix mix;
+    if (options.mix_file) {
+        if (!loadMix(options, options.mix_file, mix)) return 1;
+    } else {
+        mix.add(buildRequest(options, "GET", options.path, ""), 1);
+    }
+
+    printf("Running %ds test @ %s:%s\n", options.duration, options.host.c_str(), options.port.c_str());
+    printf("  %d threads, %d connections, %s, pipeline %d, %s\n", options.threads, options.connections,
+           options.keep_alive ? "keep-alive" : "Connection: close", options.keep_alive ? options.pipeline : 1,
+           options.rate > 0 ? ("open-loop " + std::to_string(static_cast<long>(options.rate)) + " req/s").c_str() : "closed-loop");
+    if (options.mix_file) printf("  %zu request types from %s\n", mix.requests.size(), options.mix_file);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < options.threads; ++ t) {
+        int conns = options.connections / options.threads + (t < options.connections % options.threads ? 1 : 0);
+        workers.emplace_back(std::make_unique<Worker>(options, mix, addr, addr_len, conns, nowNs() + t * 7919));
+    }
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    int64_t start = nowNs();
+    for (auto& worker: workers) threads.emplace_back([&worker, &stop] { worker->run(stop); });
+    std::this_thread::sleep_for(std::chrono::seconds(options.duration));
+    stop = true;
+    for (std::thread& t: threads) t.join();
+    double seconds = (nowNs() - start) / 1e9;
+
+    Stats total;
+    for (auto& worker: workers) {
+        Stats& s = worker->stats();
+        total.responses += s.responses;
+        total.bytes += s.bytes;
+        total.connect_errors += s.connect_errors;
+        total.io_errors += s.io_errors;
+        for (int i = 0; i < 6; ++ i) total.status[i] += s.status[i];
+        total.backlog_max = std::max(total.backlog_max, s.backlog_max);
+        total.latency.merge(s.latency);
+    }
+
+    const Histogram& h = total.latency;
+    printf("\nLatency (us)     min      p50      p90      p99    p99.9      max     mean\n");
+    printf("          %9.1f%9.1f%9.1f%9.1f%9.1f%9.1f%9.1f\n", h.min() / 1e3, h.percentile(0.5) / 1e3, h.percentile(0.9) / 1e3,
+           h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3, h.max() / 1e3, h.mean() / 1e3);
+    printf("\n%llu responses in %.2fs, %.1f MB read\n", static_cast<unsigned long long>(total.responses), seconds, total.bytes / 1e6);
+    printf("  2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu, other %llu\n", static_cast<unsigned long long>(total.status[2]),
+           static_cast<unsigned long long>(total.status[3]), static_cast<unsigned long long>(total.status[4]),
+           static_cast<unsigned long long>(total.status[5]), static_cast<unsigned long long>(total.status[0] + total.status[1]));
+    printf("  errors: connect %llu, read/write %llu\n", static_cast<unsigned long long>(total.connect_errors),
+           static_cast<unsigned long long>(total.io_errors));
+    if (options.rate > 0) printf("  max backlog: %llu requests\n", static_cast<unsigned long long>(total.backlog_max));
+    printf("Requests/sec: %.1f\n", total.responses / seconds);
+    printf("Transfer/sec: %.2f MB\n", total.bytes / seconds / 1e6);
+    return 0;
+}
@@ -0,0 +1,259 @@
+// 核心组件的微基准测试 (Google Benchmark), 用来衡量热路径上的改动
+//   ./bench
+//   ./bench --benchmark_filter=HeapTimer
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../http/http_request.hpp"
+#include "../http/HTTPConnection.hpp"
+#include "../http/ConnectionSlab.hpp"
+#include "../timer/heaptimer.hpp"
+#include "../timer/cachedclock.hpp"
+#include "../pool/ThreadPool.hpp"
+#include "../log/block_queue.hpp"
+#include "../log/log.hpp"
+
+static const std::string SMALL_GET = "GET /css/style.css HTTP/1.1\r\nHost: 127.0.0.1:8080\r\nUser-Agent: loadgen\r\nAccept: */*\r\nConnection: keep-alive\r\n\r\n";
+static const std::string LOGIN_POST = "POST /login HTTP/1.1\r\nHost: 127.0.0.1:8080\r\nContent-Type: application/x-www-form-urlencoded\r\nContent-Length: 44\r\n\r\nusername=%E5%BC%A0%E4%B8%89&password=a+b%21c";
+
+// ---- HTTP 解析 ----
+
+static void BM_ParseHttpRequest(benchmark::State& state) {
+    const std::string& raw = state.range(0) == 0 ? SMALL_GET : LOGIN_POST;
+    for (auto _ : state) {
+        HttpRequest request = parseHttpRequest(raw);
+        benchmark::DoNotOptimize(request);
+    }
+    state.SetBytesProcessed(state.iterations() * raw.size());
+}
+BENCHMARK(BM_ParseHttpRequest)->Arg(0)->Arg(1);
+
+// 服务器实际使用的零拷贝解析器, 作为 parseHttpRequest 的对照
+static void BM_HttpParser(benchmark::State& state) {
+    std::string buffer = state.range(0) == 0 ? SMALL_GET : LOGIN_POST;
+    HttpParser parser;
+    for (auto _ : state) {
+        parser.reset();
+        benchmark::DoNotOptimize(parser.parse(buffer.data(), buffer.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_HttpParser)->Arg(0)->Arg(1);
+
+static void BM_DecodeURLComponent(benchmark::State& state) {
+    const std::string encoded = "%E5%BC%A0%E4%B8%89+hello%20world%21";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HTTPConnection::decodeURLComponent(encoded));
+    }
+}
+BENCHMARK(BM_DecodeURLComponent);
+
+static void BM_ParseFormURLEncoded(benchmark::State& state) {
+    const std::string body = "username=%E5%BC%A0%E4%B8%89&password=a+b%21c";
+    for (auto _ : state) {
+        std::unordered_map<std::string, std::string> data;
+        HTTPConnection::parseFormURLEncoded(body, data);
+        benchmark::DoNotOptimize(data);
+    }
+}
+BENCHMARK(BM_ParseFormURLEncoded);
+
+// ---- 连接表: 建立并关闭 batch 个连接, fd 与内核一样从小到大复用 ----
+
+static void BM_ConnectionMapChurn(benchmark::State& state) {
+    const int batch = state.range(0);
+    std::unordered_map<int, HTTPConnection> clients;
+    for (auto _ : state) {
+        for (int fd = 0; fd < batch; ++ fd) clients.try_emplace(fd, fd, nullptr);
+        for (int fd = 0; fd < batch; ++ fd) clients.erase(fd);
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ConnectionMapChurn)->Arg(1000);
+
+static void BM_ConnectionSlabChurn(benchmark::State& state) {
+    const int batch = state.range(0);
+    ConnectionSlab clients(nullptr);
+    for (auto _ : state) {
+        for (int fd = 0; fd < batch; ++ fd) clients.open(fd);
+        for (int fd = 0; fd < batch; ++ fd) clients.close(fd);
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ConnectionSlabChurn)->Arg(1000);
+
+// ---- HeapTimer, 参数为定时器数量 ----
+
+static void BM_HeapTimerAdd(benchmark::State& state) {
+    const int n = state.range(0);
+    for (auto _ : state) {
+        HeapTimer timer;
+        for (int fd = 0; fd < n; ++ fd) timer.addTimer(fd, 5000 + fd % 1000);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_HeapTimerAdd)->Arg(1000)->Arg(100000);
+
+// keep-alive 请求刷新随机连接的定时器
+static void BM_HeapTimerUpdate(benchmark::State& state) {
+    const int n = state.range(0);
+    HeapTimer timer;
+    for (int fd = 0; fd < n; ++ fd) timer.addTimer(fd, 5000 + fd % 1000);
+    uint32_t rng = 42;
+    for (auto _ : state) {
+        rng = rng * 1664525 + 1013904223;
+        timer.updateTimer(static_cast<int>(rng % n), 5000);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HeapTimerUpdate)->Arg(1000)->Arg(100000);
+
+// 没有到期的定时器时的 tick, 每轮事件循环都会调用
+static void BM_HeapTimerTickIdle(benchmark::State& state) {
+    const int n = state.range(0);
+    HeapTimer timer;
+    for (int fd = 0; fd < n; ++ fd) timer.addTimer(fd, 60000);
+    std::vector<int> expired;
+    for (auto _ : state) {
+        timer.tick(expired);
+        benchmark::DoNotOptimize(timer.getNextTick());
+    }
+}
+BENCHMARK(BM_HeapTimerTickIdle)->Arg(100000);
+
+// 所有定时器同时到期, 一次 tick 全部取出
+static void BM_HeapTimerTickExpire(benchmark::State& state) {
+    const int n = state.range(0);
+    std::vector<int> expired;
+    expired.reserve(n);
+    for (auto _ : state) {
+        state.PauseTiming();
+        HeapTimer timer;
+        for (int fd = 0; fd < n; ++ fd) timer.addTimer(fd, 0);
+        CachedClock::getInstance().update();
+        expired.clear();
+        state.ResumeTiming();
+        timer.tick(expired);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_HeapTimerTickExpire)->Arg(10000);
+
+// ---- ThreadPool: 提交 batch 个空任务并等待全部执行完 ----
+
+static void BM_ThreadPoolEnqueue(benchmark::State& state) {
+    const int batch = state.range(0);
+    ThreadPool pool(4);
+    std::atomic<int> done{0};
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < batch; ++ i) {
+            pool.enqueue([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load(std::memory_order_acquire) < batch) std::this_thread::yield();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ThreadPoolEnqueue)->Arg(1000)->UseRealTime();
+
+// 服务器使用的路径: 不经过 std::function 的 submit
+static void BM_ThreadPoolSubmit(benchmark::State& state) {
+    const int batch = state.range(0);
+    ThreadPool pool(4);
+    std::atomic<int> done{0};
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < batch; ++ i) {
+            pool.submit([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load(std::memory_order_acquire) < batch) std::this_thread::yield();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ThreadPoolSubmit)->Arg(1000)->UseRealTime();
+
+// ---- BlockQueue ----
+
+static void BM_BlockQueuePushPop(benchmark::State& state) {
+    BlockQueue<std::string> queue;
+    const std::string item = "[INFO] Client[12] in!";
+    for (auto _ : state) {
+        queue.push(item);
+        benchmark::DoNotOptimize(queue.pop());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlockQueuePushPop);
+
+// 一个生产者一个消费者, 每次迭代传递 batch 个元素
+static void BM_BlockQueueProducerConsumer(benchmark::State& state) {
+    const int batch = state.range(0);
+    BlockQueue<int> queue(1024);
+    for (auto _ : state) {
+        std::thread consumer([&queue, batch] {
+            for (int i = 0; i < batch; ++ i) benchmark::DoNotOptimize(queue.pop());
+        });
+        for (int i = 0; i < batch; ++ i) queue.push(i);
+        consumer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_BlockQueueProducerConsumer)->Arg(100000)->UseRealTime();
+
+// ---- Logger: 调用线程上的开销, 格式化和写文件在写线程中完成 ----
+
+static void initLogger() {
+    static bool initialized = [] {
+        Logger::getInstance().init("/tmp/webserver_bench.log", true);
+        return true;
+    }();
+    (void)initialized;
+}
+
+static void BM_LoggerLog(benchmark::State& state) {
+    initLogger();
+    const std::string message = "Client[12] is closed due to timeout, and it is used 3 times.";
+    for (auto _ : state) {
+        Logger::getInstance().log(LogLevel::INFO, message);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerLog);
+
+static void BM_LoggerLogf(benchmark::State& state) {
+    initLogger();
+    int fd = 12;
+    for (auto _ : state) {
+        LOG_INFO("Client[{}] is closed due to timeout, and it is used {} times.", fd, 3);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerLogf);
+
+// 级别被过滤掉的调用
+static void BM_LoggerFiltered(benchmark::State& state) {
+    initLogger();
+    Logger::getInstance().setLevel(LogLevel::WARNING);
+    int fd = 12;
+    for (auto _ : state) {
+        LOG_INFO("Client[{}] in!", fd);
+    }
+    Logger::getInstance().setLevel(LogLevel::INFO);
+}
+BENCHMARK(BM_LoggerFiltered);
+
+// 旧的字符串接口
+static void BM_LoggerLogLegacy(benchmark::State& state) {
+    initLogger();
+    for (auto _ : state) {
+        Logger::getInstance().log("INFO", "Client[" + std::to_string(12) + "] in!");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerLogLegacy);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,75 @@
+// 10 万个空闲 keep-alive 连接下小根堆定时器与分层时间轮的对比
+//   ./timer_bench [连接数]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../timer/timer.hpp"
+#include "../timer/cachedclock.hpp"
+
+static double measure(const char* name, size_t ops, const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+    printf("  %-36s %10.1f ns/op\n", name, ns);
+    return ns;
+}
+
+static void bench(const char* title, TimerType type, int connections) {
+    printf("%s\n", title);
+    std::unique_ptr<Timer> timer = createTimer(type);
+    std::mt19937 rng(42);
+    std::vector<int> expired;
+
+    // 1. 建立连接, 超时时间 5 秒左右
+    measure("addTimer", connections, [&] {
+        for (int fd = 0; fd < connections; ++ fd) timer->addTimer(fd, 5000 + fd % 1000);
+    });
+
+    // 2. keep-alive 请求不断刷新随机连接的定时器
+    const size_t refreshes = 1000000;
+    std::vector<int> fds(refreshes);
+    for (int& fd: fds) fd = rng() % connections;
+    measure("updateTimer (keep-alive refresh)", refreshes, [&] {
+        for (int fd: fds) timer->updateTimer(fd, 5000);
+    });
+
+    // 3. 事件循环每轮都调用的时钟刷新 + getNextTick + tick, 此时没有连接过期
+    const size_t loops = 100000;
+    volatile int sink = 0;
+    measure("getNextTick + tick (idle)", loops, [&] {
+        for (size_t i = 0; i < loops; ++ i) {
+            CachedClock::getInstance().update();
+            sink = sink + timer->getNextTick();
+            timer->tick(expired);
+        }
+    });
+
+    // 4. 关闭所有连接
+    measure("removeTimer", connections, [&] {
+        for (int fd = 0; fd < connections; ++ fd) timer->removeTimer(fd);
+    });
+
+    // 5. 所有连接在 50 ms 内陆续过期
+    for (int fd = 0; fd < connections; ++ fd) timer->addTimer(fd, 1 + fd % 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    CachedClock::getInstance().update();
+    expired.clear();
+    measure("tick (expire all, per connection)", connections, [&] { timer->tick(expired); });
+    if (static_cast<int>(expired.size()) != connections) {
+        printf("  expired %zu of %d connections\n", expired.size(), connections);
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    int connections = argc > 1 ? std::atoi(argv[1]) : 100000;
+    printf("%d idle connections\n\n", connections);
+    bench("HeapTimer", TimerType::HEAP, connections);
+    bench("TimingWheel", TimerType::WHEEL, connections);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "ConnectionSlab.hpp"
+
+#include <algorithm>
+#include <sys/resource.h>
+
+ConnectionSlab::ConnectionSlab(MySQLConnector* mysql) : mysql_(mysql) {
+    size_t max_fds = MAX_FDS_;
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        max_fds = std::min<size_t>(limit.rlim_cur, MAX_FDS_);
+    }
+    blocks_.resize((max_fds + BLOCK_SIZE_ - 1) / BLOCK_SIZE_);
+}
+
+ConnectionSlab::Slot* ConnectionSlab::slot(int fd) const {
+    if (fd < 0 || static_cast<size_t>(fd) / BLOCK_SIZE_ >= blocks_.size()) return nullptr;
+    Slot* block = blocks_[fd / BLOCK_SIZE_].get();
+    return block ? &block[fd % BLOCK_SIZE_] : nullptr;
+}
+
+HTTPConnection* ConnectionSlab::open(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) / BLOCK_SIZE_ >= blocks_.size()) return nullptr;
+    auto& block = blocks_[fd / BLOCK_SIZE_];
+    if (!block) block = std::make_unique<Slot[]>(BLOCK_SIZE_);
+
+    Slot& s = block[fd % BLOCK_SIZE_];
+    if (s.conn) {
+        s.conn->reset(fd);
+    } else {
+        s.conn.emplace(fd, mysql_);
+    }
+    s.conn->in_flight.store(0, std::memory_order_relaxed);  // 只在这里归零, 关闭期间保持原值, 定时器无法再次关闭
+    s.generation.fetch_add(1, std::memory_order_relaxed);
+    s.open.store(true, std::memory_order_release);
+    return &*s.conn;
+}
+
+void ConnectionSlab::close(int fd) {
+    Slot* s = slot(fd);
+    if (s == nullptr || !s->open.load(std::memory_order_acquire)) return;
+    // 先标记为已关闭, find 不再返回该连接, 再清理连接状态
+    s->open.store(false, std::memory_order_release);
+    s->conn->reset(-1);
+}
+
+HTTPConnection* ConnectionSlab::find(int fd) {
+    Slot* s = slot(fd);
+    if (s == nullptr || !s->open.load(std::memory_order_acquire)) return nullptr;
+    return &*s->conn;
+}
+
+HTTPConnection* ConnectionSlab::findByKey(uint64_t key) {
+    Slot* s = slot(fdOf(key));
+    if (s == nullptr || !s->open.load(std::memory_order_acquire)) return nullptr;
+    if (makeKey(fdOf(key), s->generation.load(std::memory_order_relaxed)) != key) return nullptr;
+    return &*s->conn;
+}
+
+uint64_t ConnectionSlab::key(int fd) const {
+    Slot* s = slot(fd);
+    return s ? makeKey(fd, s->generation.load(std::memory_order_relaxed)) : 0;
+}
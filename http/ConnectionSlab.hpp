@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "HTTPConnection.hpp"
+
+// 以 fd 为下标的连接表. 槽位按 BLOCK_SIZE_ 个一组分配, 连接关闭后槽位连同其中的 HTTPConnection
+// 和缓冲区一起保留, 同一个 fd 再次建立连接时直接复用, 连接的建立和关闭不分配内存, 查找也不需要哈希.
+// 每次建立连接时槽位的代数加一, (代数, fd) 组成的 key 写入 epoll_event.data.u64,
+// 用来识别 fd 被新连接复用之前残留的事件和数据库结果.
+// 线程池模式下 open 只在主线程中调用, 其他线程只访问已经分发给自己的连接
+class ConnectionSlab {
+public:
+    explicit ConnectionSlab(MySQLConnector* mysql);
+    ConnectionSlab(const ConnectionSlab&) = delete;
+    ConnectionSlab& operator=(const ConnectionSlab&) = delete;
+
+    static uint64_t makeKey(int fd, uint32_t generation) { return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd); }
+    static int fdOf(uint64_t key) { return static_cast<int>(static_cast<uint32_t>(key)); }
+
+    HTTPConnection* open(int fd);  // fd 超出 RLIMIT_NOFILE 时返回 nullptr
+    void close(int fd);  // 释放连接持有的文件和缓存引用, 槽位留给下一个使用该 fd 的连接
+    HTTPConnection* find(int fd);  // 没有打开的连接时返回 nullptr
+    HTTPConnection* findByKey(uint64_t key);  // 还要求代数一致, 连接已关闭或 fd 已被复用时返回 nullptr
+    uint64_t key(int fd) const;  // 当前连接的 key, 在 open 之后调用
+
+    template<typename F>
+    void forEachOpen(F f) {
+        for (size_t b = 0; b < blocks_.size(); ++ b) {
+            if (!blocks_[b]) continue;
+            for (size_t i = 0; i < BLOCK_SIZE_; ++ i) {
+                if (blocks_[b][i].open.load(std::memory_order_acquire)) f(static_cast<int>(b * BLOCK_SIZE_ + i));
+            }
+        }
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE_ = 64;
+    static constexpr size_t MAX_FDS_ = 1 << 20;  // RLIMIT_NOFILE 为无限大时的上限
+
+    struct Slot {
+        std::optional<HTTPConnection> conn;  // 第一次使用时构造, 之后只 reset
+        std::atomic<uint32_t> generation{0};
+        std::atomic<bool> open{false};  // 槽位的 fd 由下标决定, 不单独保存
+    };
+
+    Slot* slot(int fd) const;
+
+    MySQLConnector* mysql_;
+    std::vector<std::unique_ptr<Slot[]>> blocks_;  // 按 RLIMIT_NOFILE 预先分配, 块本身在第一次使用时分配
+};
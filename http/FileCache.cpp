@@ -0,0 +1,121 @@
+#include "FileCache.hpp"
+
+#include "../timer/cachedclock.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+FileCache& FileCache::getInstance() {
+    static FileCache instance;
+    return instance;
+}
+
+void FileCache::setCapacity(size_t max_bytes, size_t max_file_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bytes_ = max_bytes;
+    max_file_bytes_ = max_file_bytes;
+    evict();
+}
+
+std::shared_ptr<const CachedFile> FileCache::get(const std::string& path) {
+    int64_t now = nowMs();
+    {
+        // 命中且在校验周期内: 只需要调整 LRU 顺序, 不做任何系统调用
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(path);
+        if (it != entries_.end() && now - it->second.checked_ms < REVALIDATE_MS) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+            return it->second.file;
+        }
+    }
+
+    struct stat st{};
+    bool exists = (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode));
+    size_t max_file_bytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_file_bytes = max_file_bytes_;
+        auto it = entries_.find(path);
+        if (it != entries_.end()) {
+            const CachedFile& cached = *it->second.file;
+            if (exists && cached.mtime == st.st_mtime && cached.size == st.st_size) {
+                it->second.checked_ms = now;
+                lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+                return it->second.file;
+            }
+            // 文件已被修改或删除, 丢弃旧的缓存
+            used_bytes_ -= entryBytes(cached);
+            lru_.erase(it->second.lru_it);
+            entries_.erase(it);
+        }
+    }
+    if (!exists) return nullptr;
+
+    std::shared_ptr<const CachedFile> file = load(path, st, max_file_bytes);
+    if (!file) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.count(path)) return file;  // 其他线程已经加载过
+    lru_.push_front(path);
+    entries_.emplace(path, Entry{file, now, lru_.begin()});
+    used_bytes_ += entryBytes(*file);
+    evict();
+    return file;
+}
+
+std::shared_ptr<const CachedFile> FileCache::load(const std::string& path, const struct stat& st, size_t max_file_bytes) {
+    auto file = std::make_shared<CachedFile>();
+    file->path = path;
+    file->size = st.st_size;
+    file->mtime = st.st_mtime;
+    file->in_memory = (static_cast<size_t>(st.st_size) <= max_file_bytes);
+
+    if (file->in_memory) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) return nullptr;
+        file->body.resize(st.st_size);
+        size_t total = 0;
+        while (total < file->body.size()) {
+            ssize_t n = read(fd, file->body.data() + total, file->body.size() - total);
+            if (n <= 0) break;
+            total += n;
+        }
+        close(fd);
+        file->body.resize(total);
+        file->size = total;
+    }
+
+    file->content_type = getContentType(path);
+    file->header = "Content-Type: " + file->content_type + "\r\n" +
+                   "Content-Length: " + std::to_string(file->size) + "\r\n";
+    return file;
+}
+
+// 调用方需持有 mutex_
+void FileCache::evict() {
+    while (used_bytes_ > max_bytes_ && !lru_.empty()) {
+        auto it = entries_.find(lru_.back());
+        used_bytes_ -= entryBytes(*it->second.file);
+        entries_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+int64_t FileCache::nowMs() {
+    return CachedClock::getInstance().nowMs();
+}
+
+std::string FileCache::getContentType(const std::string& path) {
+    if (path.ends_with(".html") || path.ends_with(".htm"))
+        return "text/html";
+    if (path.ends_with(".css"))
+        return "text/css";
+    if (path.ends_with(".js"))
+        return "application/javascript";
+    if (path.ends_with(".png"))
+        return "image/png";
+    if (path.ends_with(".jpg") || path.ends_with(".jpeg"))
+        return "image/jpeg";
+    if (path.ends_with(".txt"))
+        return "text/plain";
+    return "application/octet-stream";
+}
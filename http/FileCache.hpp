@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// 缓存中的一个静态文件, 构造完成后只读, 可以被多个线程同时持有
+struct CachedFile {
+    std::string path;  // router() 解析出的绝对路径
+    std::string body;  // 文件内容, 仅当 in_memory 为 true 时有效
+    bool in_memory = true;  // 大文件只缓存元数据, 由 sendfile 发送
+    std::string content_type;
+    std::string header;  // 预先生成的 "Content-Type: ...\r\nContent-Length: ...\r\n"
+    time_t mtime = 0;
+    off_t size = 0;
+};
+
+// 进程内共享的静态文件缓存, 按总字节数做 LRU 淘汰
+class FileCache {
+public:
+    static FileCache& getInstance();
+
+    // max_bytes: 缓存总容量; max_file_bytes: 超过该大小的文件只缓存元数据, 内容走 sendfile
+    void setCapacity(size_t max_bytes, size_t max_file_bytes);
+
+    // 返回文件内容或元数据, 文件不存在或不是普通文件时返回 nullptr
+    std::shared_ptr<const CachedFile> get(const std::string& path);
+
+    static std::string getContentType(const std::string& path);
+
+private:
+    FileCache() = default;
+
+    struct Entry {
+        std::shared_ptr<const CachedFile> file;
+        int64_t checked_ms;  // 上一次 stat 校验的时间
+        std::list<std::string>::iterator lru_it;
+    };
+
+    static constexpr int64_t REVALIDATE_MS = 1000;  // 同一文件最多每秒 stat 一次
+    // 每个条目额外计入的字节数 (路径、响应头、哈希表和链表节点), 只缓存元数据的大文件也会占用容量,
+    // 否则以不同写法 (如 "//video.mp4") 请求同一个大文件产生的条目永远不会被淘汰
+    static constexpr size_t ENTRY_OVERHEAD_BYTES = 512;
+
+    static size_t entryBytes(const CachedFile& file) { return file.body.size() + ENTRY_OVERHEAD_BYTES; }
+    std::shared_ptr<const CachedFile> load(const std::string& path, const struct stat& st, size_t max_file_bytes);
+    void evict();
+    static int64_t nowMs();
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_;  // 头部为最近使用
+    size_t used_bytes_ = 0;
+    size_t max_bytes_ = 32 * 1024 * 1024;
+    size_t max_file_bytes_ = 64 * 1024;
+};
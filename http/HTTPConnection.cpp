@@ -1,148 +1,349 @@
 #include "HTTPConnection.hpp"
 
-HTTPConnection::HTTPConnection(int client_fd, MySQLConnector* mysql) : client_fd_(client_fd), is_connection_(true), resources_root_path_("/home/amonologue/Projects/WebServer/resources") {
+const std::string HTTPConnection::resources_root_path_ = "/home/amonologue/Projects/WebServer/resources";
+
+HTTPConnection::HTTPConnection(int client_fd, MySQLConnector* mysql) : client_fd_(client_fd), is_connection_(true),
+    tracing_(Tracer::getInstance().enabled()) {
     mysql_ = mysql;
 }
 
-bool HTTPConnection::receiveRequest(std::string& raw_data) {
-    char buffer[READ_BUFFER_];
-
-    ssize_t n;
-    while ((n = recv(client_fd_, buffer, READ_BUFFER_, 0)) > 0) {
-        buffer_.append(buffer, n);
-
-        // 查找 header 结束位置
-        size_t header_end = buffer_.find("\r\n\r\n");
-        if (header_end != std::string::npos) {
-            // 查找 Content-Length
-            size_t content_len = 0;
-            size_t pos = buffer_.find("Content-Length:");
-            if (pos != std::string::npos) {
-                size_t start = pos + strlen("Content-Length:");
-                size_t end = buffer_.find("\r\n", start);
-                std::string len_str = buffer_.substr(start, end - start);
-                content_len = std::stoi(len_str);
-            }
+void HTTPConnection::reset(int client_fd) {
+    client_fd_ = client_fd;
+    use_count = 0;
+    is_keep_alive = true;
+    want_write = false;
 
-            // 当前是否已经接收完整报文
-            size_t total_expected = header_end + 4 + content_len;  // len('/r/n/r/n') = 4
-            if (buffer_.size() >= total_expected) {
-                raw_data = buffer_.substr(0, total_expected);
-                buffer_.erase(0, total_expected);  // erase the proposed request
-                return true;
-            }
-        }
-    }
+    buffer_.clear();
+    if (buffer_.capacity() > POOLED_BUFFER_) buffer_.shrink_to_fit();  // 大请求留下的缓冲区不保留
+    parser_.reset();
+    peer_closed_ = false;
+    input_full_ = false;
+    backlogged_ = false;
+    status_ = 0;
+    output_.clear();  // 关闭还没发完的 sendfile 文件
 
-    // The client closed the link
-    if (n == 0) return false;
+    awaiting_db_ = false;
+    db_query_ = nullptr;
+    db_path_.clear();
+    dispatched_ns_ = 0;
+    recv_start_ns_ = 0;
+    recv_end_ns_ = 0;
+    traces_.clear();
+}
+
+HTTPConnection::Action HTTPConnection::onReadable() {
+    // 接收请求数据
+    if (tracing_) recv_start_ns_ = Tracer::now();
+    if (!receive()) return Action::ERROR;
+    if (tracing_) recv_end_ns_ = Tracer::now();
 
-    // EAGAIN
-    return false;
+    // 处理缓冲区中所有完整的请求, 响应合并后一起发送
+    processRequests();
+    return onWritable();
 }
 
-void HTTPConnection::parseRequest(const std::string& raw_data) {
-    std::istringstream stream(raw_data);
-    std::string line;
-    ParseState state = ParseState::REQUEST_LINE;
-    std::string body;
-    bool hasBody = false;
+HTTPConnection::Action HTTPConnection::onWritable() {
+    while (true) {
+        switch (flushOutput()) {
+            case OutputQueue::FlushResult::ERROR:
+                return Action::ERROR;
+            case OutputQueue::FlushResult::AGAIN:
+                return awaiting_db_ ? Action::WAIT_DB : Action::WAIT_WRITE;
+            case OutputQueue::FlushResult::DONE:
+                break;
+        }
+        if (tracing_) finishTraces();
+        if (awaiting_db_) return Action::WAIT_DB;  // 之前的响应已发完, 后续请求等数据库返回后再处理
+        if (!is_keep_alive) return Action::CLOSE;
 
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
+        // 发送队列已清空: 继续处理因发送队列过长而暂停的请求, 以及因缓冲区已满而没有读完的数据
+        if (input_full_) {
+            if (!receive()) return Action::ERROR;
+        } else if (!backlogged_) {
+            break;
         }
+        processRequests();
+    }
+    return peer_closed_ ? Action::CLOSE : Action::WAIT_READ;
+}
 
-        switch (state) {
-            case ParseState::REQUEST_LINE:
-                parseRequestLine(line, request_);
-                state = ParseState::HEADERS;
-                break;
-            case ParseState::HEADERS:
-                if (line.empty()) {
-                    if (request_.headers.count("Content-Length")) {
-                        hasBody = true;
-                        state = ParseState::BODY;
-                    } else {
-                        state = ParseState::FINISH;
-                    }
-                } else {
-                    parseHeaderLine(line, request_);
-                }
-                break;
-            case ParseState::BODY:
-                request_.body += line;
-                state = ParseState::FINISH;
-                break;
-            case ParseState::FINISH:
+bool HTTPConnection::receive() {
+    // 边缘触发模式下必须一直读到 EAGAIN, 数据直接写入 buffer_ 的尾部
+    input_full_ = false;
+    while (true) {
+        if (buffer_.size() >= MAX_BUFFER_) {
+            input_full_ = true;  // 先处理已有的请求, 发送完成后再继续读
+            return true;
+        }
+        size_t old_size = buffer_.size();
+        buffer_.resize(old_size + READ_BUFFER_);
+        ssize_t n = recv(client_fd_, buffer_.data() + old_size, READ_BUFFER_, 0);
+        buffer_.resize(old_size + (n > 0 ? n : 0));
+        if (n > 0) continue;
+        if (n == 0) {
+            peer_closed_ = true;  // The client closed the link
+            return true;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+void HTTPConnection::processRequests() {
+    if (awaiting_db_) return;  // 响应必须按请求顺序发送
+    size_t read_pos = 0;  // 当前请求在 buffer_ 中的起始位置
+    backlogged_ = false;
+    while (true) {
+        if (output_.bytes() >= OUTPUT_HIGH_WATER_) {
+            backlogged_ = true;  // 客户端读得太慢, 等发送队列清空后再处理剩余的请求
+            break;
+        }
+
+        // 解析请求, 只扫描上次之后新到达的数据
+        int64_t parse_start = Tracer::now();
+        HttpParser::Result result = parser_.parse(buffer_.data() + read_pos, buffer_.size() - read_pos);
+        if (result == HttpParser::Result::NEED_MORE) {
+            if (input_full_) {
+                // 单个请求超过了缓冲区上限
+                result = HttpParser::Result::ERROR;
+            } else {
                 break;
+            }
+        }
+        // 解析结束的时间同时作为处理的开始时间, 每个请求只读两次时钟
+        int64_t parse_end = Tracer::now();
+        Metrics::observe(Histogram::PARSE_TIME, parse_end - parse_start);
+        if (result == HttpParser::Result::ERROR) {
+            respond(nullptr, parse_end);
+            if (tracing_) beginTrace(nullptr, parse_start, parse_end, parse_end);
+            read_pos = buffer_.size();
+            input_full_ = false;
+            parser_.reset();
+            break;
         }
 
-        if (state == ParseState::FINISH) break;
+        // 处理请求
+        respond(&parser_.request(), parse_end);
+        if (tracing_) beginTrace(&parser_.request(), parse_start, parse_end, parse_end);
+        read_pos += parser_.consumed();  // 剩余部分属于下一个 (pipelined) 请求
+        parser_.reset();
+        if (!is_keep_alive) {
+            read_pos = buffer_.size();  // Connection: close 之后的请求不再处理
+            break;
+        }
+        if (awaiting_db_) break;
     }
+    buffer_.erase(0, read_pos);
 }
 
-void HTTPConnection::sendResponse() {
-    is_keep_alive = (request_.headers["Connection"] == "keep-alive");
+void HTTPConnection::respond(const HttpRequestView* request, int64_t start) {
+    // 记录处理耗时和状态码; 开启访问日志时还记录响应大小 (加入发送队列的字节数)
+    AccessLog& access_log = AccessLog::getInstance();
+    bool logging = access_log.enabled();
+    size_t queued = output_.bytes();
+
+    if (request) {
+        sendResponse(*request);
+    } else {
+        is_keep_alive = false;
+        appendFileResponse("HTTP/1.1 400 Bad Request\r\n", FileCache::getInstance().get(resources_root_path_ + "/400.html"));
+    }
+
+    if (awaiting_db_) {
+        // 响应在数据库请求完成后才生成, 到时再记录
+        db_start_ns_ = start;
+        db_queued_ = queued;
+        return;
+    }
+    int64_t latency = Tracer::now() - start;
+    Metrics::observe(Histogram::REQUEST_LATENCY, latency);
+    Metrics::countStatus(status_);
+    if (logging) {
+        access_log.record(client_fd_, request ? request->method : std::string_view(), request ? request->path : std::string_view(),
+                          status_, output_.bytes() - queued, static_cast<uint32_t>(latency / 1000));
+    }
+}
+
+void HTTPConnection::sendResponse(const HttpRequestView& request) {
+    is_keep_alive = request.keep_alive;
     ++ use_count;
 
-    // POST
-    if (request_.method == "POST") {
-        bool success = handlePOST();
-        if (success) {
-            response_ = "HTTP/1.1 302 Found\r\nLocation: /welcome\r\nContent-Length: 0\r\nConnection: ";
-            response_ = response_ + (is_keep_alive ? "keep-alive" : "close") + "\r\n\r\n";
-            send(client_fd_, response_.c_str(), response_.size(), 0);  // 发送重定向响应
-            return ;
-        } else {
-            // TODO, Incorrect username or password;
-        }
+    // 保留路径, 返回 Prometheus 文本格式的指标
+    if (request.path == "/metrics") {
+        appendGeneratedResponse("text/plain; version=0.0.4", Metrics::getInstance().render());
+        return;
     }
+    // 保留路径, 返回保存的慢请求, Chrome trace-event JSON
+    if (request.path == "/traces") {
+        appendGeneratedResponse("application/json", Tracer::getInstance().exportChromeTrace());
+        return;
+    }
+
+    // POST, 登录和注册交给数据库线程, 响应在 onDBComplete 中生成
+    if (request.method == "POST" && startDBQuery(request)) return;
 
     // GET
-    std::string status_line;
-    std::string response_body;
-    std::string content_type;
-    std::string file_path = router();
-    std::ifstream file(file_path, std::ios::binary);
-    
+    std::shared_ptr<const CachedFile> file = FileCache::getInstance().get(router(request.path));
+    if (file) {
+        appendFileResponse("HTTP/1.1 200 OK\r\n", std::move(file));
+    } else {
+        appendFileResponse("HTTP/1.1 404 Not Found\r\n", FileCache::getInstance().get(resources_root_path_ + "/404.html"));
+    }
+}
+
+void HTTPConnection::finishPOST(bool success) {
+    if (success) {
+        status_ = 302;
+        response_ = output_.takeBuffer();
+        response_ += "HTTP/1.1 302 Found\r\nLocation: /welcome\r\nContent-Length: 0\r\nDate: ";
+        response_ += CachedClock::getInstance().httpDate();
+        response_ += "\r\nConnection: ";
+        response_ += (is_keep_alive ? "keep-alive" : "close");
+        response_ += "\r\n\r\n";
+        output_.append(std::move(response_));  // 重定向响应
+        return ;
+    }
+
+    // TODO, Incorrect username or password; 目前返回原页面
+    std::shared_ptr<const CachedFile> file = FileCache::getInstance().get(router(db_path_));
+    if (file) {
+        appendFileResponse("HTTP/1.1 200 OK\r\n", std::move(file));
+    } else {
+        appendFileResponse("HTTP/1.1 404 Not Found\r\n", FileCache::getInstance().get(resources_root_path_ + "/404.html"));
+    }
+}
+
+std::function<bool()> HTTPConnection::takeDBQuery() {
+    return std::move(db_query_);
+}
+
+HTTPConnection::Action HTTPConnection::onDBComplete(bool success) {
+    awaiting_db_ = false;
+    db_query_ = nullptr;
+    finishPOST(success);
+    if (tracing_ && !traces_.empty()) {
+        // 等待数据库的请求一定是最后一个
+        int64_t now = Tracer::now();
+        RequestTrace& trace = traces_.back();
+        trace.end_ns[static_cast<int>(TraceStage::DB)] = now;
+        trace.start_ns[static_cast<int>(TraceStage::SEND)] = now;
+        trace.status = status_;
+    }
+
+    int64_t latency = Tracer::now() - db_start_ns_;
+    Metrics::observe(Histogram::REQUEST_LATENCY, latency);
+    Metrics::countStatus(status_);
+    AccessLog& access_log = AccessLog::getInstance();
+    if (access_log.enabled()) {
+        access_log.record(client_fd_, "POST", db_path_, status_, output_.bytes() - db_queued_, static_cast<uint32_t>(latency / 1000));
+    }
+
+    // 继续处理等待期间到达的请求
+    processRequests();
+    return onWritable();
+}
+
+void HTTPConnection::appendFileResponse(const char* status_line, std::shared_ptr<const CachedFile> file) {
+    // 大文件不进入用户态, 由 sendfile 从文件直接发送到 socket
+    int file_fd = -1;
+    if (file && !file->in_memory) {
+        file_fd = open(file->path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_fd == -1) file = nullptr;
+    }
+
+    status_ = atoi(status_line + 9);  // "HTTP/1.1 200 OK\r\n"
+    response_ = output_.takeBuffer();  // 复用已发送的响应头的内存
+    response_ += status_line;
+    response_ += "Date: ";
+    response_ += CachedClock::getInstance().httpDate();
+    response_ += "\r\n";
     if (file) {
-        status_line = "HTTP/1.1 200 OK\r\n";
-        response_body = readFile(file_path);
-        content_type = getContentType(file_path);
+        response_ += file->header;
     } else {
-        status_line = "HTTP/1.1 404 Not Found\r\n";
-        response_body = readFile("/home/amonologue/Projects/WebServer/resources/404.html");
-        content_type = "text/html";
+        response_ += "Content-Length: 0\r\n";
+    }
+    response_ += "Connection: ";
+    response_ += (is_keep_alive ? "keep-alive" : "close");
+    response_ += "\r\n\r\n";
+
+    output_.append(std::move(response_));
+    if (file_fd != -1) {
+        output_.appendFile(file_fd, file->size);
+    } else if (file) {
+        output_.append(std::move(file));  // 小文件直接引用缓存中的内容, 与 header 一起 writev
     }
+}
+
+void HTTPConnection::appendGeneratedResponse(const char* content_type, std::string body) {
+    status_ = 200;
+    response_ = "HTTP/1.1 200 OK\r\nContent-Type: " + std::string(content_type) + "\r\nContent-Length: " + std::to_string(body.size()) +
+                "\r\nDate: " + CachedClock::getInstance().httpDate() + "\r\nConnection: " + (is_keep_alive ? "keep-alive" : "close") + "\r\n\r\n";
+    output_.append(std::move(response_));
+    output_.append(std::move(body));
+}
 
-    response_ = 
-        status_line + 
-        "Content-Type: " + content_type + "\r\n" + 
-        "Content-Length: " + std::to_string(response_body.size()) + "\r\n" + 
-        "Connection: " + (is_keep_alive ? "keep-alive" : "close") + "\r\n\r\n" + 
-        response_body;
-    
-    send(client_fd_, response_.c_str(), response_.size(), 0);  // 发送响应
+OutputQueue::FlushResult HTTPConnection::flushOutput() {
+    if (output_.empty()) return OutputQueue::FlushResult::DONE;
+    size_t before = output_.bytes();
+    int64_t start = Tracer::now();
+    OutputQueue::FlushResult result = output_.flush(client_fd_);
+    Metrics::observe(Histogram::SEND_TIME, Tracer::now() - start);
+    Metrics::add(Counter::BYTES_SENT, before - output_.bytes());
+    return result;
 }
 
-std::string HTTPConnection::router() {
-    std::string file_absolute_path;
+void HTTPConnection::beginTrace(const HttpRequestView* request, int64_t parse_start, int64_t parse_end, int64_t handle_start) {
+    int64_t now = Tracer::now();
+    RequestTrace& trace = traces_.emplace_back();
+    trace.fd = client_fd_;
+    if (request) trace.setRequest(request->method, request->path);
+    // 同一次读取中的 pipelined 请求共享排队和读取阶段
+    if (dispatched_ns_ != 0 && dispatched_ns_ <= recv_start_ns_) trace.mark(TraceStage::QUEUE, dispatched_ns_, recv_start_ns_);
+    if (recv_start_ns_ != 0) trace.mark(TraceStage::RECV, recv_start_ns_, recv_end_ns_);
+    trace.mark(TraceStage::PARSE, parse_start, parse_end);
+    trace.mark(TraceStage::HANDLE, handle_start, now);
+    if (awaiting_db_) {
+        trace.start_ns[static_cast<int>(TraceStage::DB)] = now;  // 结束时间和状态码在 onDBComplete 中填写
+    } else {
+        trace.status = status_;
+        trace.start_ns[static_cast<int>(TraceStage::SEND)] = now;
+    }
+}
+
+void HTTPConnection::finishTraces() {
+    if (traces_.empty()) return;
+    size_t done = traces_.size() - (awaiting_db_ ? 1 : 0);
+    int64_t now = Tracer::now();
+    Tracer& tracer = Tracer::getInstance();
+    for (size_t i = 0; i < done; ++ i) {
+        traces_[i].end_ns[static_cast<int>(TraceStage::SEND)] = now;
+        tracer.finish(traces_[i]);
+    }
+    traces_.erase(traces_.begin(), traces_.begin() + done);
+}
+
+bool HTTPConnection::hasPendingOutput() const {
+    return !output_.empty();
+}
+
+const std::string& HTTPConnection::router(std::string_view path) {
+    std::string& file_absolute_path = file_path_;  // 复用内存
+    file_absolute_path = resources_root_path_;
     // 路由匹配
-    if (request_.path == "/") {
-        file_absolute_path = resources_root_path_ + "/index.html";
-    } else if (request_.path == "/picture") {
-        file_absolute_path = resources_root_path_ + "/picture.html";
-    } else if (request_.path == "/video") {
-        file_absolute_path = resources_root_path_ + "/video.html";
-    } else if (request_.path == "/login") {
-        file_absolute_path = resources_root_path_ + "/login.html";
-    } else if (request_.path == "/register") {
-        file_absolute_path = resources_root_path_ + "/register.html";
-    } else if (request_.path == "/welcome") {
-        file_absolute_path = resources_root_path_ + "/welcome.html";
+    if (path == "/") {
+        file_absolute_path += "/index.html";
+    } else if (path == "/picture") {
+        file_absolute_path += "/picture.html";
+    } else if (path == "/video") {
+        file_absolute_path += "/video.html";
+    } else if (path == "/login") {
+        file_absolute_path += "/login.html";
+    } else if (path == "/register") {
+        file_absolute_path += "/register.html";
+    } else if (path == "/welcome") {
+        file_absolute_path += "/welcome.html";
     } else {
-        file_absolute_path = resources_root_path_ + request_.path;
+        file_absolute_path += path;
     }
     return file_absolute_path;
 }
@@ -151,16 +352,22 @@ void HTTPConnection::handleGET() {
 
 }
 
-bool HTTPConnection::handlePOST() {
-    bool success = false;
+bool HTTPConnection::startDBQuery(const HttpRequestView& request) {
+    if (request.path != "/register" && request.path != "/login") return false;
     std::unordered_map<std::string, std::string> account;
-    parseFormURLEncoded(request_.body, account);
-    if (request_.path == "/register") {
-        success = mysql_->insertUser(account["username"], account["password"]);
-    } else if (request_.path == "/login") {
-        success = mysql_->verifyUser(account["username"], account["password"]);
+    parseFormURLEncoded(std::string(request.body), account);
+    // 查询只捕获值, 执行时连接可能已经关闭
+    MySQLConnector* mysql = mysql_;
+    std::string username = std::move(account["username"]);
+    std::string password = std::move(account["password"]);
+    if (request.path == "/register") {
+        db_query_ = [mysql, username, password] { return mysql->insertUser(username, password); };
+    } else {
+        db_query_ = [mysql, username, password] { return mysql->verifyUser(username, password); };
     }
-    return success;
+    db_path_ = std::string(request.path);
+    awaiting_db_ = true;
+    return true;
 }
 
 std::string HTTPConnection::decodeURLComponent(const std::string& s) {
@@ -182,29 +389,6 @@ std::string HTTPConnection::decodeURLComponent(const std::string& s) {
     return result;
 }
 
-std::string HTTPConnection::getContentType(const std::string& path) {
-    if (path.ends_with(".html") || path.ends_with(".htm"))
-        return "text/html";
-    if (path.ends_with(".css"))
-        return "text/css";
-    if (path.ends_with(".js"))
-        return "application/javascript";
-    if (path.ends_with(".png"))
-        return "image/png";
-    if (path.ends_with(".jpg") || path.ends_with(".jpeg"))
-        return "image/jpeg";
-    if (path.ends_with(".txt"))
-        return "text/plain";
-    return "application/octet-stream";
-}
-
-std::string HTTPConnection::readFile(const std::string& file_path) {
-    std::ifstream file(file_path, std::ios::binary);
-    std::ostringstream oss;
-    oss << file.rdbuf();
-    return oss.str();
-}
-
 void HTTPConnection::parseFormURLEncoded(const std::string& body, std::unordered_map<std::string, std::string>& data) {
     std::istringstream stream(body);
     std::string pair;
@@ -1,38 +1,98 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <functional>
 #include <cstring>
 #include <fstream>
 #include <netinet/in.h>
+#include <fcntl.h>
 #include "http_request.hpp"
+#include "FileCache.hpp"
+#include "OutputQueue.hpp"
 #include "../sql/MySQLConnector.hpp"
+#include "../timer/cachedclock.hpp"
+#include "../log/access_log.hpp"
+#include "../metrics/metrics.hpp"
+#include "../metrics/trace.hpp"
 
 class HTTPConnection {
 public:
+    // 处理完一次 epoll 事件后连接的下一步动作
+    enum class Action {
+        WAIT_READ,  // 等待下一个请求
+        WAIT_WRITE,  // 还有未发送的数据, 需要关注 EPOLLOUT
+        WAIT_DB,  // 正在等待数据库请求完成, 之后的 pipelined 请求暂停处理, 见 takeDBQuery()
+        CLOSE,  // 请求要求关闭连接
+        ERROR  // 对端关闭或读写出错
+    };
+
     int use_count = 0;
-    bool is_keep_alive;
+    bool is_keep_alive = true;
+    bool want_write = false;  // 当前是否在 epoll 中关注 EPOLLOUT
+    std::atomic<int> in_flight{0};  // 线程池模式下已分发但尚未完成的事件数, -1 表示已被定时器关闭, 由 ConnectionSlab::open 归零
 
     explicit HTTPConnection(int client_fd, MySQLConnector* mysql);
 
-    bool receiveRequest(std::string& raw_data);
-    void parseRequest(const std::string& raw_data);
-    void sendResponse();
+    // 由 ConnectionSlab 复用连接对象: 清空所有状态, 保留缓冲区的容量. client_fd 为 -1 表示连接已关闭,
+    // 此时释放发送队列中的文件和缓存引用
+    void reset(int client_fd);
+    void setDispatchTime(int64_t ns) { dispatched_ns_ = ns; }  // 线程池模式下事件被分发的时间, 用于追踪排队耗时
+
+    Action onReadable();  // 读取并处理请求, 然后尽量发送响应
+    Action onWritable();  // 继续发送未发完的响应
+    // 取出待提交的数据库查询 (登录/注册), 没有新的查询时返回空; 查询在数据库线程中执行, 不访问连接
+    std::function<bool()> takeDBQuery();
+    Action onDBComplete(bool success);  // 数据库请求完成, 发送 POST 的响应并继续处理后续请求
+    bool awaitingDB() const { return awaiting_db_; }
+
+    void sendResponse(const HttpRequestView& request);  // 把响应加入发送队列
+    OutputQueue::FlushResult flushOutput();  // 尽可能多地发送队列中的数据
+    bool hasPendingOutput() const;
+
+    static std::string decodeURLComponent(const std::string& s);  // 解码 %XX 和 '+'
+    static void parseFormURLEncoded(const std::string& body, std::unordered_map<std::string, std::string>& data);
 
 private:
-    const int READ_BUFFER_ = 4096;
+    static constexpr size_t READ_BUFFER_ = 4096;  // 每次 recv 的大小
+    static constexpr size_t MAX_BUFFER_ = HttpParser::MAX_HEADER_BYTES + HttpParser::MAX_BODY_BYTES + READ_BUFFER_;
+    static constexpr size_t OUTPUT_HIGH_WATER_ = 1024 * 1024;  // 发送队列超过该大小时暂停处理后续的 pipelined 请求
+    static constexpr size_t POOLED_BUFFER_ = 64 * 1024;  // 复用连接时保留的接收缓冲区容量上限
+    static const std::string resources_root_path_;  // 所有连接共享
     int client_fd_;
-    std::string resources_root_path_;
-    std::string buffer_;
-    HttpRequest request_;
+    std::string buffer_;  // 接收缓冲区, 从当前请求的起始位置开始
+    HttpParser parser_;
+    bool peer_closed_ = false;  // 对端已关闭写端, 处理完缓冲区中的请求后关闭连接
+    bool input_full_ = false;  // buffer_ 达到上限, socket 中可能还有没读完的数据
+    bool backlogged_ = false;  // 因发送队列过长, buffer_ 中还有未处理的完整请求
     std::string response_;
+    std::string file_path_;  // router() 的结果
+    int status_ = 0;  // 最近一个响应的状态码, 用于访问日志
+    OutputQueue output_;  // 尚未写入 socket 的响应数据
     bool is_connection_;
     MySQLConnector* mysql_;
+    bool awaiting_db_ = false;  // 已发出数据库请求, 还没有收到结果
+    std::function<bool()> db_query_;  // 尚未被取走提交的查询
+    std::string db_path_;  // 等待结果的 POST 请求的路径, 失败时返回该路径对应的页面
+    // 等待数据库期间暂存的访问日志和指标字段, 完成时再记录
+    int64_t db_start_ns_ = 0;  // 见 Tracer::now()
+    size_t db_queued_ = 0;
+    // 开启慢请求追踪时使用, 时间戳见 Tracer::now()
+    const bool tracing_;
+    int64_t dispatched_ns_ = 0;
+    int64_t recv_start_ns_ = 0;  // 最近一次读取 socket
+    int64_t recv_end_ns_ = 0;
+    std::vector<RequestTrace> traces_;  // 响应已加入发送队列但还没有发完的请求, 按请求顺序
 
-    std::string router();
+    bool receive();
+    void processRequests();
+    void respond(const HttpRequestView* request, int64_t start);  // request 为 nullptr 表示请求格式错误, start 为解析完成的时间
+    void appendFileResponse(const char* status_line, std::shared_ptr<const CachedFile> file);
+    void appendGeneratedResponse(const char* content_type, std::string body);  // /metrics, /traces
+    const std::string& router(std::string_view path);  // 返回值在下一次调用前有效
     void handleGET();
-    bool handlePOST();
-    std::string decodeURLComponent(const std::string& s);
-    std::string getContentType(const std::string& path);
-    std::string readFile(const std::string& file_path);
-    void parseFormURLEncoded(const std::string& body, std::unordered_map<std::string, std::string>& data);
+    bool startDBQuery(const HttpRequestView& request);
+    void finishPOST(bool success);
+    void beginTrace(const HttpRequestView* request, int64_t parse_start, int64_t parse_end, int64_t handle_start);
+    void finishTraces();  // 发送队列已清空, 提交已发完的请求
 };
\ No newline at end of file
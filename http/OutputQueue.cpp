@@ -0,0 +1,119 @@
+#include "OutputQueue.hpp"
+
+#include <cerrno>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+
+OutputQueue::~OutputQueue() {
+    clear();
+}
+
+void OutputQueue::append(std::string data) {
+    if (data.empty()) return;
+    Chunk chunk;
+    chunk.size = data.size();
+    chunk.data = std::move(data);
+    push(std::move(chunk));
+}
+
+void OutputQueue::append(std::shared_ptr<const CachedFile> file) {
+    if (!file || file->body.empty()) return;
+    Chunk chunk;
+    chunk.size = file->body.size();
+    chunk.file = std::move(file);
+    push(std::move(chunk));
+}
+
+void OutputQueue::appendFile(int file_fd, size_t size) {
+    if (size == 0) {
+        close(file_fd);
+        return;
+    }
+    Chunk chunk;
+    chunk.file_fd = file_fd;
+    chunk.size = size;
+    push(std::move(chunk));
+}
+
+std::string OutputQueue::takeBuffer() {
+    if (spare_.empty()) return std::string();
+    std::string buffer = std::move(spare_.back());
+    spare_.pop_back();
+    buffer.clear();
+    return buffer;
+}
+
+void OutputQueue::push(Chunk&& chunk) {
+    bytes_ += chunk.size;
+    chunks_.push_back(std::move(chunk));
+}
+
+OutputQueue::FlushResult OutputQueue::flush(int sock_fd) {
+    while (!empty()) {
+        ssize_t n;
+        if (chunks_[head_].file_fd != -1) {
+            Chunk& chunk = chunks_[head_];
+            n = sendfile(sock_fd, chunk.file_fd, &chunk.offset, chunk.size - chunk.offset);
+            if (n > 0) {
+                bytes_ -= n;
+                if (static_cast<size_t>(chunk.offset) == chunk.size) popFront();
+                continue;
+            }
+            if (n == 0) return FlushResult::ERROR;  // 文件在发送过程中被截断
+        } else {
+            // 把队首连续的内存块合并成一次 writev
+            iovec iov[MAX_IOV_];
+            int iov_cnt = 0;
+            for (auto it = chunks_.begin() + head_; it != chunks_.end() && it->file_fd == -1 && iov_cnt < MAX_IOV_; ++ it) {
+                iov[iov_cnt].iov_base = const_cast<char*>(it->memory()) + it->offset;
+                iov[iov_cnt].iov_len = it->size - it->offset;
+                ++ iov_cnt;
+            }
+            n = writev(sock_fd, iov, iov_cnt);
+            if (n > 0) {
+                bytes_ -= n;
+                size_t left = n;
+                while (left > 0) {
+                    Chunk& chunk = chunks_[head_];
+                    size_t remain = chunk.size - chunk.offset;
+                    if (left < remain) {
+                        chunk.offset += left;
+                        break;
+                    }
+                    left -= remain;
+                    popFront();
+                }
+                continue;
+            }
+        }
+
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return FlushResult::AGAIN;
+        return FlushResult::ERROR;
+    }
+    return FlushResult::DONE;
+}
+
+void OutputQueue::clear() {
+    while (!empty()) popFront();
+    bytes_ = 0;
+}
+
+void OutputQueue::popFront() {
+    Chunk& chunk = chunks_[head_];
+    if (chunk.file_fd != -1) close(chunk.file_fd);
+    chunk.file = nullptr;  // 尽早释放对缓存文件的引用
+    if (chunk.data.capacity() > std::string().capacity() && chunk.data.capacity() <= MAX_SPARE_BYTES_ && spare_.size() < MAX_SPARE_) {
+        spare_.push_back(std::move(chunk.data));
+    }
+    ++ head_;
+    if (head_ == chunks_.size()) {
+        chunks_.clear();
+        head_ = 0;
+    } else if (head_ >= 64 && head_ * 2 >= chunks_.size()) {
+        // 队列一直没有清空时, 回收已发送的部分
+        chunks_.erase(chunks_.begin(), chunks_.begin() + head_);
+        head_ = 0;
+    }
+}
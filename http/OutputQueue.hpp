@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <climits>
+#include <sys/types.h>
+#include "FileCache.hpp"
+
+// 每个连接的待发送队列, 按顺序保存响应头、缓存中的 body 以及需要 sendfile 的文件区间
+class OutputQueue {
+public:
+    enum class FlushResult {
+        DONE,  // 队列已全部写入 socket
+        AGAIN,  // socket 发送缓冲区已满, 需要等待 EPOLLOUT
+        ERROR  // 连接出错
+    };
+
+    OutputQueue() = default;
+    ~OutputQueue();
+    OutputQueue(const OutputQueue&) = delete;
+    OutputQueue& operator=(const OutputQueue&) = delete;
+
+    void append(std::string data);
+    void append(std::shared_ptr<const CachedFile> file);  // 发送缓存中的文件内容
+    void appendFile(int file_fd, size_t size);  // 通过 sendfile 发送, 发送完成后关闭 file_fd
+    // 取一个已发送完的字符串复用其内存, 用来生成下一个响应头, 之后再通过 append 交还
+    std::string takeBuffer();
+
+    FlushResult flush(int sock_fd);
+    bool empty() const { return head_ == chunks_.size(); }
+    size_t bytes() const { return bytes_; }  // 尚未发送的字节数
+    void clear();
+
+private:
+    struct Chunk {
+        std::string data;
+        std::shared_ptr<const CachedFile> file;
+        int file_fd = -1;
+        off_t offset = 0;  // 已发送的字节数 (对 file_fd 即为文件偏移)
+        size_t size = 0;
+
+        const char* memory() const { return file ? file->body.data() : data.data(); }
+    };
+
+    static constexpr int MAX_IOV_ = IOV_MAX;  // 一次 writev 最多合并的块数, pipelined 请求的响应可以一次发出
+    static constexpr size_t MAX_SPARE_ = 4;  // 保留的空闲字符串数
+    static constexpr size_t MAX_SPARE_BYTES_ = 16 * 1024;  // 超过该容量的字符串不保留
+
+    void push(Chunk&& chunk);
+    void popFront();
+
+    // [head_, size) 为待发送的块, 队列清空时 clear() 保留容量, 不像 deque 那样反复分配和释放节点
+    std::vector<Chunk> chunks_;
+    size_t head_ = 0;
+    std::vector<std::string> spare_;
+    size_t bytes_ = 0;
+};
@@ -1,63 +1,264 @@
 #include "http_request.hpp"
+#include "simd_scan.hpp"
 
-void parseRequestLine(const std::string& line, HttpRequest& request) {
-    std::istringstream stream(line);
-    stream >> request.method >> request.path >> request.version;
+#include <cstring>
+#include <algorithm>
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++ i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x += 'a' - 'A';
+        if (y >= 'A' && y <= 'Z') y += 'a' - 'A';
+        if (x != y) return false;
+    }
+    return true;
+}
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
 }
 
-void parseHeaderLine(const std::string& line, HttpRequest& request) {
-    size_t pos = line.find(":");
-    if (pos != std::string::npos) {
-        // Content-Type: text/html
-        // Content-Length: 46
-        // Connection: close
-        std::string key = line.substr(0, pos);
-        std::string value = line.substr(pos + 1);
-        while (!value.empty() && value.front() == ' ')
-            value.erase(value.begin());
-        request.headers[key] = value;
+std::string_view HttpRequestView::header(std::string_view name) const {
+    for (size_t i = 0; i < header_count; ++ i) {
+        if (equalsIgnoreCase(headers[i].name, name)) return headers[i].value;
     }
+    return {};
 }
 
-HttpRequest parseHttpRequest(const std::string& raw) {
-    std::istringstream stream(raw);
-    std::string line;
-    ParseState state = ParseState::REQUEST_LINE;
-    HttpRequest request;
-    std::string body;
-    bool hasBody = false;
+void HttpParser::reset() {
+    state_ = State::REQUEST_LINE;
+    pos_ = 0;
+    scan_ = 0;
+    headers_end_ = 0;
+    header_count_ = 0;
+    content_length_ = 0;
+    chunked_ = false;
+    body_start_ = 0;
+    body_end_ = 0;
+    chunk_remaining_ = 0;
+}
 
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
+// 找到从 pos_ 开始的一行, line_end 为去掉 "\r\n" 后的结尾, next 为下一行的起始位置
+bool HttpParser::nextLine(const char* data, size_t size, size_t& line_end, size_t& next) {
+    if (scan_ < pos_) scan_ = pos_;
+    size_t lf = scanChar(data, size, scan_, '\n');
+    if (lf == SCAN_NPOS) {
+        scan_ = size;
+        return false;
+    }
+    next = lf + 1;
+    line_end = next - 1;
+    if (line_end > pos_ && data[line_end - 1] == '\r') -- line_end;
+    scan_ = next;
+    return true;
+}
 
-        switch (state) {
-            case ParseState::REQUEST_LINE:
-                parseRequestLine(line, request);
-                state = ParseState::HEADERS;
-                break;
-            case ParseState::HEADERS:
-                if (line.empty()) {
-                    if (request.headers.count("Content-Length")) {
-                        hasBody = true;
-                        state = ParseState::BODY;
-                    } else {
-                        state = ParseState::FINISH;
+HttpParser::Result HttpParser::parse(char* data, size_t size) {
+    while (state_ != State::COMPLETE) {
+        size_t line_end, next;
+        switch (state_) {
+            case State::REQUEST_LINE:
+            case State::HEADERS:
+                if (headers_end_ == 0) {
+                    // 先用向量化扫描找到 header 结尾的空行, 之后逐行解析时不会再遇到数据不完整的情况
+                    if (state_ == State::REQUEST_LINE) {
+                        while (pos_ < size && (data[pos_] == '\r' || data[pos_] == '\n')) ++ pos_;  // 忽略请求之前多余的空行
+                    }
+                    size_t end = scanHeaderEnd(data, size, std::max(scan_, pos_));
+                    if (end == SCAN_NPOS) {
+                        scan_ = std::max(pos_, size >= 2 ? size - 2 : 0);  // 空行可能跨越两次 recv
+                        return size - pos_ > MAX_HEADER_BYTES ? Result::ERROR : Result::NEED_MORE;
                     }
-                } else {
-                    parseHeaderLine(line, request);
+                    if (end - pos_ > MAX_HEADER_BYTES) return Result::ERROR;
+                    headers_end_ = end;
+                }
+                {
+                    size_t lf = scanChar(data, headers_end_, pos_, '\n');
+                    next = lf + 1;
+                    line_end = (lf > pos_ && data[lf - 1] == '\r') ? lf - 1 : lf;
                 }
+                if (state_ == State::REQUEST_LINE) {
+                    if (!parseRequestLine(data, line_end)) return Result::ERROR;
+                    state_ = State::HEADERS;
+                } else if (line_end == pos_) {
+                    pos_ = next;
+                    if (!finishHeaders(data)) return Result::ERROR;
+                    continue;
+                } else if (!parseHeaderLine(data, line_end)) {
+                    return Result::ERROR;
+                }
+                pos_ = next;
+                break;
+
+            case State::BODY:
+                if (size - pos_ < content_length_) return Result::NEED_MORE;
+                body_start_ = pos_;
+                body_end_ = pos_ + content_length_;
+                pos_ = body_end_;
+                state_ = State::COMPLETE;
+                break;
+
+            case State::CHUNK_SIZE: {
+                if (!nextLine(data, size, line_end, next)) return Result::NEED_MORE;
+                size_t chunk_size = 0;
+                size_t i = pos_;
+                for (; i < line_end; ++ i) {
+                    char c = data[i];
+                    int digit;
+                    if (c >= '0' && c <= '9') digit = c - '0';
+                    else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+                    else break;
+                    chunk_size = chunk_size * 16 + digit;
+                    if (chunk_size > MAX_BODY_BYTES) return Result::ERROR;
+                }
+                if (i == pos_ || (i < line_end && data[i] != ';' && data[i] != ' ')) return Result::ERROR;
+                if (body_end_ - body_start_ + chunk_size > MAX_BODY_BYTES) return Result::ERROR;
+                pos_ = next;
+                chunk_remaining_ = chunk_size;
+                state_ = chunk_size == 0 ? State::TRAILERS : State::CHUNK_DATA;
                 break;
-            case ParseState::BODY:
-                request.body += line;
-                state = ParseState::FINISH;
+            }
+
+            case State::CHUNK_DATA: {
+                // 把分块数据向前移动到已解码内容的结尾, 使 body 在缓冲区中连续
+                size_t take = std::min(size - pos_, chunk_remaining_);
+                if (take > 0 && body_end_ != pos_) memmove(data + body_end_, data + pos_, take);
+                body_end_ += take;
+                pos_ += take;
+                chunk_remaining_ -= take;
+                if (chunk_remaining_ > 0) return Result::NEED_MORE;
+                state_ = State::CHUNK_DATA_END;
+                break;
+            }
+
+            case State::CHUNK_DATA_END:
+                if (!nextLine(data, size, line_end, next)) return Result::NEED_MORE;
+                if (line_end != pos_) return Result::ERROR;
+                pos_ = next;
+                state_ = State::CHUNK_SIZE;
                 break;
-            case ParseState::FINISH:
+
+            case State::TRAILERS:
+                if (!nextLine(data, size, line_end, next)) return Result::NEED_MORE;
+                if (line_end == pos_) state_ = State::COMPLETE;  // trailer 字段直接忽略
+                pos_ = next;
+                break;
+
+            case State::COMPLETE:
                 break;
         }
+    }
+
+    buildRequest(data);
+    return Result::COMPLETE;
+}
+
+// METHOD SP request-target SP HTTP-version
+bool HttpParser::parseRequestLine(const char* data, size_t end) {
+    const char* begin = data + pos_;
+    const char* line_end = data + end;
+    const char* sp1 = static_cast<const char*>(memchr(begin, ' ', line_end - begin));
+    if (sp1 == nullptr || sp1 == begin) return false;
+    const char* sp2 = static_cast<const char*>(memchr(sp1 + 1, ' ', line_end - sp1 - 1));
+    if (sp2 == nullptr || sp2 == sp1 + 1 || sp2 + 1 == line_end) return false;
+
+    method_ = {static_cast<uint32_t>(pos_), static_cast<uint32_t>(sp1 - begin)};
+    target_ = {static_cast<uint32_t>(sp1 + 1 - data), static_cast<uint32_t>(sp2 - sp1 - 1)};
+    version_ = {static_cast<uint32_t>(sp2 + 1 - data), static_cast<uint32_t>(line_end - sp2 - 1)};
+    return line_end - sp2 - 1 > 5 && std::string_view(sp2 + 1, 5) == "HTTP/";
+}
+
+// name ":" OWS value OWS
+bool HttpParser::parseHeaderLine(const char* data, size_t end) {
+    if (header_count_ == HttpRequestView::MAX_HEADERS) return false;
+    const char* begin = data + pos_;
+    size_t colon_pos = scanChar(data, end, pos_, ':');
+    if (colon_pos == SCAN_NPOS || colon_pos == pos_) return false;
+    const char* colon = data + colon_pos;
 
-        if (state == ParseState::FINISH) break;
+    std::string_view value = trim(std::string_view(colon + 1, data + end - colon - 1));
+    header_names_[header_count_] = {static_cast<uint32_t>(pos_), static_cast<uint32_t>(colon - begin)};
+    header_values_[header_count_] = {static_cast<uint32_t>(value.data() - data), static_cast<uint32_t>(value.size())};
+    ++ header_count_;
+    return true;
+}
+
+bool HttpParser::finishHeaders(const char* data) {
+    body_start_ = body_end_ = pos_;
+    bool has_length = false;
+    for (size_t i = 0; i < header_count_; ++ i) {
+        std::string_view name(data + header_names_[i].off, header_names_[i].len);
+        std::string_view value(data + header_values_[i].off, header_values_[i].len);
+        if (equalsIgnoreCase(name, "Content-Length")) {
+            if (value.empty()) return false;
+            size_t length = 0;
+            for (char c: value) {
+                if (c < '0' || c > '9') return false;
+                length = length * 10 + (c - '0');
+                if (length > MAX_BODY_BYTES) return false;
+            }
+            // 多个取值不同的 Content-Length 无法确定请求的边界 (RFC 9112 6.3)
+            if (has_length && length != content_length_) return false;
+            has_length = true;
+            content_length_ = length;
+        } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked_ = equalsIgnoreCase(value, "chunked");
+            if (!chunked_) return false;  // 不支持其他传输编码
+        }
     }
+
+    if (chunked_ && has_length) return false;  // 同时出现时前后端可能对边界理解不一致, 直接拒绝
+    if (chunked_) {
+        state_ = State::CHUNK_SIZE;
+    } else if (content_length_ > 0) {
+        state_ = State::BODY;
+    } else {
+        state_ = State::COMPLETE;
+    }
+    return true;
+}
+
+void HttpParser::buildRequest(const char* data) {
+    auto view = [data](Span span) { return std::string_view(data + span.off, span.len); };
+
+    request_.method = view(method_);
+    std::string_view target = view(target_);
+    size_t question = target.find('?');
+    request_.path = target.substr(0, question);
+    request_.query = question == std::string_view::npos ? std::string_view() : target.substr(question + 1);
+    request_.version = view(version_);
+    request_.header_count = header_count_;
+    for (size_t i = 0; i < header_count_; ++ i) {
+        request_.headers[i] = {view(header_names_[i]), view(header_values_[i])};
+    }
+    request_.body = std::string_view(data + body_start_, body_end_ - body_start_);
+
+    // HTTP/1.1 默认保持连接, HTTP/1.0 需要显式的 keep-alive
+    std::string_view connection = request_.header("Connection");
+    if (request_.version == "HTTP/1.1") {
+        request_.keep_alive = !equalsIgnoreCase(connection, "close");
+    } else {
+        request_.keep_alive = equalsIgnoreCase(connection, "keep-alive");
+    }
+}
+
+HttpRequest parseHttpRequest(const std::string& raw) {
+    HttpRequest request;
+    std::string buffer = raw;
+    HttpParser parser;
+    if (parser.parse(buffer.data(), buffer.size()) != HttpParser::Result::COMPLETE) return request;
+
+    const HttpRequestView& view = parser.request();
+    request.method = view.method;
+    request.path = view.path;
+    request.version = view.version;
+    for (size_t i = 0; i < view.header_count; ++ i) {
+        request.headers[std::string(view.headers[i].name)] = std::string(view.headers[i].value);
+    }
+    request.body = view.body;
     return request;
-}
\ No newline at end of file
+}
@@ -2,8 +2,10 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <sstream>
+#include <cstdint>
 
 struct HttpRequest
 {
@@ -14,15 +16,92 @@ struct HttpRequest
     std::string body;
 };
 
-enum class ParseState {
-    REQUEST_LINE,
-    HEADERS,
-    BODY,
-    FINISH
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
 };
 
-void parseRequestLine(const std::string& line, HttpRequest& request);
+// 解析结果, 所有字段都指向连接的接收缓冲区, 缓冲区被修改后失效
+struct HttpRequestView {
+    static constexpr size_t MAX_HEADERS = 32;
 
-void parseHeaderLine(const std::string& line, HttpRequest& request);
+    std::string_view method;
+    std::string_view path;  // 不含查询参数
+    std::string_view query;  // '?' 之后的部分
+    std::string_view version;
+    HttpHeader headers[MAX_HEADERS];
+    size_t header_count = 0;
+    std::string_view body;  // 分块编码时为解码后的内容
+    bool keep_alive = false;
 
-HttpRequest parseHttpRequest(const std::string& raw);
\ No newline at end of file
+    // 按名称查找 header, 大小写不敏感, 不存在时返回空
+    std::string_view header(std::string_view name) const;
+};
+
+// 可恢复的 HTTP/1.1 请求解析器, 直接在接收缓冲区上工作, 不分配内存.
+// 数据不完整时返回 NEED_MORE, 下次调用从上次扫描到的位置继续, 已扫描的部分不会被重新扫描
+class HttpParser {
+public:
+    enum class Result {
+        NEED_MORE,  // 请求还不完整
+        COMPLETE,  // 已解析出一个完整请求, 见 request() 和 consumed()
+        ERROR  // 请求格式错误或超出限制
+    };
+
+    static constexpr size_t MAX_HEADER_BYTES = 8 * 1024;  // 请求行 + 所有 header 的最大长度
+    static constexpr size_t MAX_BODY_BYTES = 1024 * 1024;
+
+    // data 指向当前请求的起始位置, size 为已接收的字节数. 两次调用之间 data 可以被重新分配,
+    // 但 [0, size) 中已有的内容不能改变. 分块编码的 body 会在 data 中原地解码
+    Result parse(char* data, size_t size);
+    // 解析出的请求, 只在 parse 返回 COMPLETE 之后有效
+    const HttpRequestView& request() const { return request_; }
+    // 完整请求占用的字节数, 之后的数据属于下一个 (pipelined) 请求
+    size_t consumed() const { return pos_; }
+    // 准备解析下一个请求
+    void reset();
+
+private:
+    enum class State {
+        REQUEST_LINE,
+        HEADERS,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_END,
+        TRAILERS,
+        COMPLETE
+    };
+
+    // 以偏移量保存位置, 这样缓冲区重新分配后仍然有效
+    struct Span {
+        uint32_t off = 0;
+        uint32_t len = 0;
+    };
+
+    bool nextLine(const char* data, size_t size, size_t& line_end, size_t& next);
+    bool parseRequestLine(const char* data, size_t end);
+    bool parseHeaderLine(const char* data, size_t end);
+    bool finishHeaders(const char* data);
+    void buildRequest(const char* data);
+
+    State state_ = State::REQUEST_LINE;
+    size_t pos_ = 0;  // 当前行 (或 body) 的起始位置
+    size_t scan_ = 0;  // 已扫描过的位置, 新数据到达后从这里继续
+    size_t headers_end_ = 0;  // header 结尾空行之后的位置, 0 表示还没找到
+    Span method_, target_, version_;
+    Span header_names_[HttpRequestView::MAX_HEADERS];
+    Span header_values_[HttpRequestView::MAX_HEADERS];
+    size_t header_count_ = 0;
+    size_t content_length_ = 0;
+    bool chunked_ = false;
+    size_t body_start_ = 0;
+    size_t body_end_ = 0;  // 分块编码时已解码内容的结尾
+    size_t chunk_remaining_ = 0;
+    HttpRequestView request_;
+};
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b);
+
+// 一次性解析完整的请求文本, 返回拥有内存的副本
+HttpRequest parseHttpRequest(const std::string& raw);
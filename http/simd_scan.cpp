@@ -0,0 +1,123 @@
+#include "simd_scan.hpp"
+
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// 找到匹配的 '\n' 之后, 计算空行之后第一个字节的位置
+static inline size_t headerEndAt(const char* data, size_t p) {
+    return data[p + 1] == '\n' ? p + 2 : p + 3;
+}
+
+size_t scanHeaderEndScalar(const char* data, size_t size, size_t from) {
+    for (size_t p = from; p + 1 < size; ++ p) {
+        if (data[p] != '\n') continue;
+        if (data[p + 1] == '\n') return p + 2;
+        if (p + 2 < size && data[p + 1] == '\r' && data[p + 2] == '\n') return p + 3;
+    }
+    return SCAN_NPOS;
+}
+
+static size_t scanCharScalar(const char* data, size_t size, size_t from, char c) {
+    if (from >= size) return SCAN_NPOS;
+    const void* p = memchr(data + from, c, size - from);
+    return p ? static_cast<const char*>(p) - data : SCAN_NPOS;
+}
+
+#ifdef SCAN_X86
+
+// 每次比较 32 字节: 位置 i 为 '\n', 且 i + 1 为 '\n' 或 i + 1, i + 2 为 "\r\n"
+__attribute__((target("avx2")))
+static size_t scanHeaderEndAvx2(const char* data, size_t size, size_t from) {
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    size_t i = from;
+    for (; i + 2 + 32 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 2));
+        __m256i next = _mm256_or_si256(_mm256_cmpeq_epi8(b, lf), _mm256_and_si256(_mm256_cmpeq_epi8(b, cr), _mm256_cmpeq_epi8(c, lf)));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, lf), next));
+        if (mask != 0) return headerEndAt(data, i + __builtin_ctz(mask));
+    }
+    return scanHeaderEndScalar(data, size, i);
+}
+
+__attribute__((target("avx2")))
+static size_t scanCharAvx2(const char* data, size_t size, size_t from, char ch) {
+    const __m256i target = _mm256_set1_epi8(ch);
+    size_t i = from;
+    for (; i + 32 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, target));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return scanCharScalar(data, size, i, ch);
+}
+
+// SSE2 是 x86-64 的基础指令集, 不需要运行时检测
+static size_t scanHeaderEndSse2(const char* data, size_t size, size_t from) {
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    size_t i = from;
+    for (; i + 2 + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2));
+        __m128i next = _mm_or_si128(_mm_cmpeq_epi8(b, lf), _mm_and_si128(_mm_cmpeq_epi8(b, cr), _mm_cmpeq_epi8(c, lf)));
+        uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, lf), next));
+        if (mask != 0) return headerEndAt(data, i + __builtin_ctz(mask));
+    }
+    return scanHeaderEndScalar(data, size, i);
+}
+
+static size_t scanCharSse2(const char* data, size_t size, size_t from, char ch) {
+    const __m128i target = _mm_set1_epi8(ch);
+    size_t i = from;
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, target));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return scanCharScalar(data, size, i, ch);
+}
+
+static bool hasAvx2() {
+    static const bool has_avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return has_avx2;
+}
+
+size_t scanHeaderEnd(const char* data, size_t size, size_t from) {
+    return hasAvx2() ? scanHeaderEndAvx2(data, size, from) : scanHeaderEndSse2(data, size, from);
+}
+
+size_t scanChar(const char* data, size_t size, size_t from, char c) {
+    return hasAvx2() ? scanCharAvx2(data, size, from, c) : scanCharSse2(data, size, from, c);
+}
+
+const char* scanImplementation() {
+    return hasAvx2() ? "avx2" : "sse2";
+}
+
+#else
+
+size_t scanHeaderEnd(const char* data, size_t size, size_t from) {
+    return scanHeaderEndScalar(data, size, from);
+}
+
+size_t scanChar(const char* data, size_t size, size_t from, char c) {
+    return scanCharScalar(data, size, from, c);
+}
+
+const char* scanImplementation() {
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+// 请求分帧用的向量化扫描函数. x86-64 上运行时选择 AVX2 或 SSE2 实现, 其他平台使用标量实现.
+// 所有函数都从 from 开始扫描, 调用方记录上次扫描到的位置, 新数据到达后只扫描新增的部分
+
+constexpr size_t SCAN_NPOS = static_cast<size_t>(-1);
+
+// 查找 header 结束处的空行 ("\r\n\r\n" 或 "\n\n"), 返回空行之后第一个字节的位置.
+// 没找到时返回 SCAN_NPOS, 此时下次可以从 size - 2 继续扫描
+size_t scanHeaderEnd(const char* data, size_t size, size_t from);
+
+// 查找字符 c, 没找到时返回 SCAN_NPOS
+size_t scanChar(const char* data, size_t size, size_t from, char c);
+
+// 当前使用的实现: "avx2", "sse2" 或 "scalar"
+const char* scanImplementation();
+
+// 标量实现, 供测试和基准对比
+size_t scanHeaderEndScalar(const char* data, size_t size, size_t from);
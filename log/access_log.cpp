@@ -0,0 +1,93 @@
+#include "access_log.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "../timer/cachedclock.hpp"
+
+AccessLog::AccessLog() : dropped_(0), writer_(4096) {
+    writer_.setEncoder([this](const LogRing::Record& record, std::string& out) { encode(record, out); });
+    writer_.setFileHeader([this](std::string& out) { beginSegment(out); });
+}
+
+AccessLog::~AccessLog() {
+    writer_.stop();  // 写线程会回调本对象, 先于成员析构停止
+}
+
+AccessLog& AccessLog::getInstance() {
+    static AccessLog instance;
+    return instance;
+}
+
+void AccessLog::init(const std::string& filename) {
+    if (!writer_.open(filename)) {
+        std::cerr << "Cannot open access log file: " << filename << ": " << strerror(errno) << "\n";
+        exit(1);
+    }
+    enabled_.store(true, std::memory_order_release);
+    writer_.start();
+}
+
+void AccessLog::record(int client_fd, std::string_view method, std::string_view path, int status, uint64_t bytes, uint32_t latency_us) {
+    LogRing::Record* record = writer_.tryClaim();
+    if (record == nullptr) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Entry entry;
+    entry.time_ms = CachedClock::getInstance().wallTimeMs();
+    entry.bytes = bytes;
+    entry.latency_us = latency_us;
+    entry.fd = client_fd;
+    entry.status = static_cast<uint16_t>(status);
+    entry.path_len = static_cast<uint16_t>(std::min(path.size(), sizeof(record->data) - sizeof(Entry)));
+    entry.method = AccessLogFormat::methodCode(method);
+    memcpy(record->data, &entry, sizeof(entry));
+    memcpy(record->data + sizeof(entry), path.data(), entry.path_len);
+    record->length = static_cast<uint32_t>(sizeof(entry) + entry.path_len);
+
+    writer_.publish(record);
+}
+
+// 每次打开或切分出新文件都写入段头, 解码器据此重置路径表和时间基准
+void AccessLog::beginSegment(std::string& out) {
+    out.append(AccessLogFormat::MAGIC, sizeof(AccessLogFormat::MAGIC));
+    out += static_cast<char>(AccessLogFormat::VERSION);
+    paths_.clear();
+    last_time_ms_ = 0;
+}
+
+void AccessLog::encode(const LogRing::Record& record, std::string& out) {
+    Entry entry;
+    memcpy(&entry, record.data, sizeof(entry));
+    std::string_view path(record.data + sizeof(entry), entry.path_len);
+
+    uint32_t path_id = 0;
+    auto it = paths_.find(std::string(path));
+    if (it != paths_.end()) {
+        path_id = it->second;
+    } else if (paths_.size() < MAX_PATHS_) {
+        path_id = static_cast<uint32_t>(paths_.size() + 1);
+        paths_.emplace(path, path_id);
+        out += static_cast<char>(AccessLogFormat::TAG_PATH);
+        AccessLogFormat::putVarint(out, path_id);
+        AccessLogFormat::putVarint(out, path.size());
+        out += path;
+    }
+
+    out += static_cast<char>(AccessLogFormat::TAG_ENTRY);
+    AccessLogFormat::putVarint(out, AccessLogFormat::zigzag(entry.time_ms - last_time_ms_));
+    last_time_ms_ = entry.time_ms;
+    AccessLogFormat::putVarint(out, static_cast<uint32_t>(entry.fd));
+    out += static_cast<char>(entry.method);
+    AccessLogFormat::putVarint(out, path_id);
+    if (path_id == 0) {
+        AccessLogFormat::putVarint(out, path.size());
+        out += path;
+    }
+    AccessLogFormat::putVarint(out, entry.status);
+    AccessLogFormat::putVarint(out, entry.bytes);
+    AccessLogFormat::putVarint(out, entry.latency_us);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include "log_writer.hpp"
+#include "access_log_format.hpp"
+
+// 二进制访问日志: 每个请求一条定长记录写入与运行日志相同的写入管道 (LogWriter), 由写线程做路径驻留、
+// varint/差分编码后批量写入文件, 格式见 access_log_format.hpp. 缓冲区满时丢弃并计数.
+// 切分后的每个文件都以段头开始, 可以单独解码
+class AccessLog {
+public:
+    static AccessLog& getInstance();
+    void setRotation(const LogRotation& rotation) { writer_.setRotation(rotation); }  // 在 init 之前调用
+    void init(const std::string& filename);
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    void record(int client_fd, std::string_view method, std::string_view path, int status, uint64_t bytes, uint32_t latency_us);
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t MAX_PATHS_ = 4096;  // 驻留的路径数上限, 超出后直接写入路径内容, 避免随机路径撑大表
+
+    // 缓冲区记录中 data 的布局, 后面紧跟路径
+    struct Entry {
+        int64_t time_ms;
+        uint64_t bytes;
+        uint32_t latency_us;
+        int32_t fd;
+        uint16_t status;
+        uint16_t path_len;
+        uint8_t method;
+    };
+
+    AccessLog();
+    ~AccessLog();
+    void encode(const LogRing::Record& record, std::string& out);
+    void beginSegment(std::string& out);  // 写入段头并重置路径表和时间基准
+
+    std::atomic<bool> enabled_{false};
+    std::atomic<uint64_t> dropped_;
+
+    // 以下只由写线程访问
+    std::unordered_map<std::string, uint32_t> paths_;
+    int64_t last_time_ms_ = 0;
+
+    LogWriter writer_;
+};
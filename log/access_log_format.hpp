@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// 二进制访问日志的文件格式, 由 AccessLog 写入, tools/access_log_decode 解析.
+//   段头:   "WSAL" + 版本号 (1 字节), 每次打开文件时写入, 解码器遇到段头时重置状态
+//   路径:   TAG_PATH, varint 编号, varint 长度, 内容  (编号从 1 开始, 只在段内有效)
+//   访问:   TAG_ENTRY, zigzag varint 与上一条的时间差 (ms), varint fd, 方法 (1 字节),
+//           varint 路径编号 (0 表示后面紧跟 varint 长度 + 内容), varint 状态码, varint 响应字节数, varint 处理耗时 (us)
+struct AccessLogFormat {
+    static constexpr char MAGIC[4] = {'W', 'S', 'A', 'L'};
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t TAG_PATH = 1;
+    static constexpr uint8_t TAG_ENTRY = 2;
+
+    enum Method : uint8_t { GET, POST, HEAD, PUT, DELETE, OTHER };
+    static constexpr const char* METHOD_NAMES[] = {"GET", "POST", "HEAD", "PUT", "DELETE", "-"};
+
+    static Method methodCode(std::string_view method) {
+        for (uint8_t i = 0; i < OTHER; ++ i) {
+            if (method == METHOD_NAMES[i]) return static_cast<Method>(i);
+        }
+        return OTHER;
+    }
+
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    static bool getVarint(const char*& p, const char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(*p ++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    static uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+    static int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+};
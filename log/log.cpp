@@ -1,12 +1,17 @@
 #include "log.hpp"
 
-Logger::Logger() : running_(false), async_(true) {}
+#include <cerrno>
+#include <charconv>
+
+static const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+Logger::Logger() : policy_(OverflowPolicy::DROP), level_(LogLevel::INFO), dropped_(0), reported_dropped_(0), async_(true), writer_(8192) {
+    writer_.setEncoder(&Logger::formatRecord);
+    writer_.setBatchTrailer([this](std::string& out) { appendDroppedWarning(out); });
+}
 
 Logger::~Logger() {
-    running_ = false;
-    if (write_thread_.joinable()) write_thread_.join();
-    flush();
-    if (log_file_.is_open()) log_file_.close();
+    writer_.stop();  // 写线程会回调本对象, 先于成员析构停止
 }
 
 Logger& Logger::getInstance() {
@@ -14,43 +19,165 @@ Logger& Logger::getInstance() {
     return instance;
 }
 
-void Logger::init(const std::string& filename, bool async) {
+void Logger::init(const std::string& filename, bool async, OverflowPolicy policy) {
     async_ = async;
-    log_file_.open(filename, std::ios::app);
-    if (!log_file_.is_open()) {
-        std::cerr << "Cannot open log file: " << filename << "\n";
+    policy_ = policy;
+    if (!writer_.open(filename)) {
+        std::cerr << "Cannot open log file: " << filename << ": " << strerror(errno) << "\n";
         exit(1);
     }
-
-    running_ = true;
-    if (async_) {
-        write_thread_ = std::thread(&Logger::writeLog, this);
-    }
+    initialized_.store(true, std::memory_order_release);
+    if (async_) writer_.start();
 }
 
 /* level: ["INFO", "DEBUG", "WARNING", "ERROR"] */
 void Logger::log(const std::string& level, const std::string& message) {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << "[" << std::put_time(std::localtime(&now_c), "%F %T") << "]\t" << "[" << level << "]\t" << message << "\n";
+    LogLevel value = LogLevel::INFO;
+    for (int i = 0; i < 4; ++ i) {
+        if (level == LEVEL_NAMES[i]) value = static_cast<LogLevel>(i);
+    }
+    log(value, message);
+}
+
+void Logger::log(LogLevel level, std::string_view message) {
+    if (!initialized_.load(std::memory_order_acquire) || !isEnabled(level)) return;
+    LogRing::Record local;
+    LogRing::Record* record = async_ ? claim() : &local;
+    if (record == nullptr) return;
+
+    record->time = CachedClock::getInstance().wallTime();
+    record->format = nullptr;
+    record->level = static_cast<uint8_t>(level);
+    record->length = static_cast<uint32_t>(std::min(message.size(), sizeof(record->data)));
+    memcpy(record->data, message.data(), record->length);
 
     if (async_) {
-        queue_.push(ss.str());
+        commit(record);
     } else {
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        log_file_ << ss.str();
+        writeSync(record);
     }
 }
 
-void Logger::flush() {
-    log_file_.flush();
+LogRing::Record* Logger::claim() {
+    LogRing::Record* record = writer_.tryClaim();
+    while (record == nullptr) {
+        if (policy_ == OverflowPolicy::DROP) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        writer_.wake();
+        std::this_thread::yield();
+        record = writer_.tryClaim();
+    }
+    return record;
+}
+
+void Logger::commit(LogRing::Record* record) {
+    writer_.publish(record);
+}
+
+void Logger::writeSync(LogRing::Record* record) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    writer_.writeRecord(*record);
 }
 
-void Logger::writeLog() {
-    while (running_) {
-        std::string msg = queue_.pop();
-        log_file_ << msg;
-        flush();
+void Logger::appendDroppedWarning(std::string& out) {
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped == reported_dropped_) return;
+    LogRing::Record warning;
+    warning.time = CachedClock::getInstance().wallTime();
+    warning.format = "{} log records dropped, log buffer is full";
+    warning.level = static_cast<uint8_t>(LogLevel::WARNING);
+    ArgWriter writer{warning.data, sizeof(warning.data)};
+    writer.put(dropped - reported_dropped_);
+    warning.length = static_cast<uint32_t>(writer.len);
+    formatRecord(warning, out);
+    reported_dropped_ = dropped;
+}
+
+// "[时间]\t[级别]\t消息\n", 延迟格式化的记录在这里把 "{}" 依次替换为参数
+void Logger::formatRecord(const LogRing::Record& record, std::string& out) {
+    out += '[';
+    out += CachedClock::getInstance().logTimestamp(record.time);
+    out += "]\t[";
+    out += LEVEL_NAMES[record.level];
+    out += "]\t";
+    if (record.format == nullptr) {
+        out.append(record.data, record.length);
+        out += '\n';
+        return;
     }
-}
\ No newline at end of file
+
+    const char* data = record.data;
+    size_t pos = 0;
+    char num[32];
+    auto appendArg = [&]() {
+        if (pos >= record.length) return false;
+        ArgType type = static_cast<ArgType>(data[pos ++]);
+        switch (type) {
+            case ARG_INT: {
+                int64_t v;
+                memcpy(&v, data + pos, sizeof(v));
+                pos += sizeof(v);
+                out.append(num, std::to_chars(num, num + sizeof(num), v).ptr);
+                break;
+            }
+            case ARG_UINT: {
+                uint64_t v;
+                memcpy(&v, data + pos, sizeof(v));
+                pos += sizeof(v);
+                out.append(num, std::to_chars(num, num + sizeof(num), v).ptr);
+                break;
+            }
+            case ARG_DOUBLE: {
+                double v;
+                memcpy(&v, data + pos, sizeof(v));
+                pos += sizeof(v);
+                out.append(num, std::to_chars(num, num + sizeof(num), v).ptr);
+                break;
+            }
+            case ARG_BOOL:
+                out += data[pos ++] ? "true" : "false";
+                break;
+            case ARG_CHAR:
+                out += data[pos ++];
+                break;
+            case ARG_STRING: {
+                uint16_t n;
+                memcpy(&n, data + pos, sizeof(n));
+                pos += sizeof(n);
+                out.append(data + pos, n);
+                pos += n;
+                break;
+            }
+            default:
+                return false;
+        }
+        return true;
+    };
+
+    for (const char* p = record.format; *p != '\0'; ) {
+        const char* brace = strchr(p, '{');
+        if (brace == nullptr) {
+            out += p;
+            break;
+        }
+        out.append(p, brace - p);
+        if (brace[1] == '}') {
+            if (!appendArg()) out += "{}";  // 参数不足 (或被截断) 时原样输出
+            p = brace + 2;
+        } else {
+            out += '{';
+            p = brace[1] == '{' ? brace + 2 : brace + 1;  // "{{" 输出为 "{"
+        }
+    }
+    out += '\n';
+}
+
+void Logger::flush() {
+    if (!async_) return;
+    while (writer_.running() && writer_.pending()) {
+        writer_.wake();
+        std::this_thread::yield();
+    }
+}
@@ -1,30 +1,170 @@
 #pragma once
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <vector>
 #include <thread>
 #include <atomic>
-#include <chrono>
-#include <ctime>
-#include <sstream>
+#include <mutex>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
 #include <iostream>
-#include "block_queue.hpp"
+#include "log_ring.hpp"
+#include "log_writer.hpp"
+#include "../timer/cachedclock.hpp"
+
+enum class LogLevel : uint8_t {
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR
+};
+
+// 编译期的最低级别, 低于该级别的 LOG_XXX 调用连同参数的求值一起被删除.
+// 0: DEBUG, 1: INFO, 2: WARNING, 3: ERROR, 例如 cmake -DLOG_COMPILE_LEVEL=1
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+// 用法: LOG_INFO("Client[{}] in!", fd); 格式串必须是字符串字面量, 参数在写线程中才被格式化
+#define LOG_AT(level, ...) \
+    do { \
+        Logger& logger_ = Logger::getInstance(); \
+        if (logger_.isEnabled(level)) logger_.logf(level, __VA_ARGS__); \
+    } while (0)
+
+#if LOG_COMPILE_LEVEL <= 0
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 1
+#define LOG_INFO(...) LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 2
+#define LOG_WARNING(...) LOG_AT(LogLevel::WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) ((void)0)
+#endif
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERROR, __VA_ARGS__)
+
+// 异步模式下缓冲区满时的处理方式
+enum class OverflowPolicy {
+    DROP,  // 丢弃并计数, 写线程稍后写入一条丢弃数量的警告, 调用方永远不会阻塞
+    BLOCK  // 等待写线程腾出空间, 不丢日志
+};
 
 class Logger {
 public:
     static Logger& getInstance();
-    void init(const std::string& filename = "webserver.log", bool async = true);
+    void init(const std::string& filename = "webserver.log", bool async = true, OverflowPolicy policy = OverflowPolicy::DROP);
+    void setRotation(const LogRotation& rotation) { writer_.setRotation(rotation); }  // 在 init 之前调用
+    void setLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    bool isEnabled(LogLevel level) const { return level >= level_.load(std::memory_order_relaxed); }
+
+    // 兼容旧接口, level: ["INFO", "DEBUG", "WARNING", "ERROR"]
     void log(const std::string& level, const std::string& message);
-    void flush();
+    void log(LogLevel level, std::string_view message);
+
+    // 只把参数按二进制编码进日志记录, "{}" 的替换在写线程中完成
+    template<typename... Args>
+    void logf(LogLevel level, const char* format, const Args&... args);
+
+    void flush();  // 等待缓冲区中的日志全部写入文件
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    size_t queueDepth() const { return writer_.queueDepth(); }  // 尚未写入文件的日志条数
 
 private:
+    // 参数的编码: 1 字节类型 + 定长数值, 字符串为 2 字节长度 + 内容
+    enum ArgType : uint8_t { ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_BOOL, ARG_CHAR, ARG_STRING };
+
+    struct ArgWriter {
+        char* data;
+        size_t cap;
+        size_t len = 0;
+        bool full = false;  // 写满之后忽略剩余的参数
+
+        void putRaw(ArgType type, const void* value, size_t size) {
+            if (full || len + 1 + size > cap) {
+                full = true;
+                return;
+            }
+            data[len ++] = static_cast<char>(type);
+            memcpy(data + len, value, size);
+            len += size;
+        }
+        void putString(std::string_view s) {
+            if (full || len + 3 > cap) {
+                full = true;
+                return;
+            }
+            uint16_t n = static_cast<uint16_t>(std::min(s.size(), cap - len - 3));
+            data[len ++] = static_cast<char>(ARG_STRING);
+            memcpy(data + len, &n, sizeof(n));
+            memcpy(data + len + sizeof(n), s.data(), n);
+            len += sizeof(n) + n;
+        }
+        template<typename T>
+        void put(const T& value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                putRaw(ARG_BOOL, &value, sizeof(value));
+            } else if constexpr (std::is_same_v<T, char>) {
+                putRaw(ARG_CHAR, &value, sizeof(value));
+            } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+                if constexpr (std::is_signed_v<T> || std::is_enum_v<T>) {
+                    int64_t v = static_cast<int64_t>(value);
+                    putRaw(ARG_INT, &v, sizeof(v));
+                } else {
+                    uint64_t v = value;
+                    putRaw(ARG_UINT, &v, sizeof(v));
+                }
+            } else if constexpr (std::is_floating_point_v<T>) {
+                double v = value;
+                putRaw(ARG_DOUBLE, &v, sizeof(v));
+            } else {
+                putString(std::string_view(value));  // std::string, string_view, const char*
+            }
+        }
+    };
+
     Logger();
     ~Logger();
-    void writeLog();
+    LogRing::Record* claim();
+    void commit(LogRing::Record* record);
+    void writeSync(LogRing::Record* record);
+    void appendDroppedWarning(std::string& out);  // 写线程在每批日志之后调用
+    static void formatRecord(const LogRing::Record& record, std::string& out);
 
-    std::ofstream log_file_;
-    BlockQueue<std::string> queue_;
-    std::thread write_thread_;
-    std::atomic<bool> running_;
+    std::atomic<bool> initialized_{false};  // init 成功后置位, 日志调用只检查它, 文件只由写线程访问
+    OverflowPolicy policy_;
+    std::atomic<LogLevel> level_;
+    std::atomic<uint64_t> dropped_;  // 累计丢弃的日志条数
+    uint64_t reported_dropped_;  // 已经写入警告的丢弃条数, 只由写线程访问
     bool async_;
-    std::mutex log_mutex_;
-};
\ No newline at end of file
+    std::mutex log_mutex_;  // 同步模式下串行化写入
+    LogWriter writer_;  // 环形缓冲区、写线程和文件切分
+};
+
+template<typename... Args>
+void Logger::logf(LogLevel level, const char* format, const Args&... args) {
+    if (!initialized_.load(std::memory_order_acquire)) return;
+    LogRing::Record local;
+    LogRing::Record* record = async_ ? claim() : &local;
+    if (record == nullptr) return;  // 缓冲区满, 已计入丢弃数
+
+    record->time = CachedClock::getInstance().wallTime();
+    record->format = format;
+    record->level = static_cast<uint8_t>(level);
+    ArgWriter writer{record->data, sizeof(record->data)};
+    (writer.put(args), ...);
+    record->length = static_cast<uint32_t>(writer.len);
+
+    if (async_) {
+        commit(record);
+    } else {
+        writeSync(record);
+    }
+}
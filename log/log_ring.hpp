@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 日志用的多生产者单消费者环形缓冲区, 所有记录在构造时预先分配.
+// 生产者用 CAS 抢占一个槽位, 直接在槽位中格式化日志行再发布, 消费者 (写线程) 按顺序批量取出
+class LogRing {
+public:
+    static constexpr size_t RECORD_SIZE = 512;
+
+    struct Record {
+        std::atomic<size_t> seq;
+        size_t pos;  // 抢占到的位置, 发布时使用
+        int64_t time;  // 写日志时的墙上时间 (s)
+        const char* format;  // 延迟格式化的格式串, 必须是字符串字面量; nullptr 表示 data 中是已经完整的消息
+        uint32_t length;  // data 中有效的字节数
+        uint8_t level;
+        char data[RECORD_SIZE - 3 * sizeof(size_t) - sizeof(const char*) - sizeof(uint32_t) - sizeof(uint8_t)];  // 消息或编码后的参数, 超出的部分会被截断
+    };
+
+    // 容量必须是 2 的幂
+    explicit LogRing(size_t capacity = 8192) : mask_(capacity - 1), records_(new Record[capacity]) {
+        for (size_t i = 0; i < capacity; ++ i) {
+            records_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // 生产者: 抢占一个空闲记录, 缓冲区满时返回 nullptr
+    Record* tryClaim() {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Record& record = records_[pos & mask_];
+            size_t seq = record.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    record.pos = pos;
+                    return &record;
+                }
+            } else if (diff < 0) {
+                return nullptr;  // 满
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 生产者: 记录写完之后发布给消费者
+    void publish(Record* record) {
+        record->seq.store(record->pos + 1, std::memory_order_release);
+    }
+
+    // 消费者: 第 offset 条待处理的记录, 尚未发布时返回 nullptr
+    Record* peek(size_t offset) {
+        size_t pos = head_.load(std::memory_order_relaxed) + offset;
+        Record& record = records_[pos & mask_];
+        return record.seq.load(std::memory_order_acquire) == pos + 1 ? &record : nullptr;
+    }
+
+    // 消费者: 释放前 count 条记录, 供生产者重新使用
+    void pop(size_t count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++ i, ++ head) {
+            records_[head & mask_].seq.store(head + mask_ + 1, std::memory_order_release);
+        }
+        head_.store(head, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+    // 近似的待处理记录数 (包括已抢占尚未发布的), 只用于监控
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    const size_t mask_;
+    std::unique_ptr<Record[]> records_;
+    alignas(64) std::atomic<size_t> head_{0};  // 只由消费者修改, 其他线程只在 size() 中读取
+    alignas(64) std::atomic<size_t> tail_{0};
+};
@@ -0,0 +1,226 @@
+#include "log_writer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "../timer/cachedclock.hpp"
+
+LogWriter::LogWriter(size_t capacity) : ring_(capacity), fd_(-1), file_bytes_(0), file_day_(0), rotate_day_(0), rotate_index_(-1), rotate_retry_time_(0),
+                                        running_(false), writer_sleeping_(false), wake_seq_(0) {}
+
+LogWriter::~LogWriter() {
+    stop();
+    if (fd_ != -1) close(fd_);
+}
+
+bool LogWriter::open(const std::string& filename) {
+    filename_ = filename;
+    return openFile();
+}
+
+void LogWriter::start() {
+    running_ = true;
+    batch_.reserve(MAX_BATCH_ * LogRing::RECORD_SIZE);
+    write_thread_ = std::thread(&LogWriter::writeLoop, this);
+}
+
+void LogWriter::stop() {
+    running_ = false;
+    wake();
+    if (write_thread_.joinable()) write_thread_.join();
+}
+
+void LogWriter::publish(LogRing::Record* record) {
+    ring_.publish(record);
+    std::atomic_thread_fence(std::memory_order_seq_cst);  // 与写线程休眠前的检查配对
+    if (writer_sleeping_.load()) wake();
+}
+
+void LogWriter::wake() {
+    wake_seq_.fetch_add(1);
+    wake_seq_.notify_one();
+}
+
+void LogWriter::writeRecord(const LogRing::Record& record) {
+    batch_.clear();
+    encode_(record, batch_);
+    if (rotateIfNeeded(batch_.size())) {
+        batch_.clear();
+        encode_(record, batch_);
+    }
+    writeAll(batch_.data(), batch_.size());
+}
+
+void LogWriter::encodeBatch(size_t count) {
+    for (size_t i = 0; i < count; ++ i) encode_(*ring_.peek(i), batch_);
+}
+
+void LogWriter::writeLoop() {
+    while (true) {
+        // 取出所有已发布的记录, 编码到同一个缓冲区后一次写入
+        size_t count = 0;
+        while (count < MAX_BATCH_ && ring_.peek(count) != nullptr) ++ count;
+        batch_.clear();
+        encodeBatch(count);
+        if (!batch_.empty() && rotateIfNeeded(batch_.size())) {
+            // 新文件的编码状态已经由文件头重置 (访问日志的路径表), 这一批要重新编码
+            batch_.clear();
+            encodeBatch(count);
+        }
+        ring_.pop(count);
+        if (batch_trailer_) batch_trailer_(batch_);
+        if (!batch_.empty()) writeAll(batch_.data(), batch_.size());
+        if (count > 0) continue;
+
+        // 没有新记录时休眠, 先声明休眠再检查一次, 避免错过检查之后发布的记录
+        uint32_t seq = wake_seq_.load();
+        writer_sleeping_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_.peek(0) == nullptr) {
+            if (!running_) break;
+            wake_seq_.wait(seq);
+        }
+        writer_sleeping_.store(false);
+    }
+    writer_sleeping_.store(false);
+}
+
+void LogWriter::writeAll(const char* data, size_t size) {
+    file_bytes_ += size;
+    while (size > 0) {
+        ssize_t n = write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+int LogWriter::localDay(time_t time) {
+    tm local{};
+    localtime_r(&time, &local);
+    return (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+}
+
+// 打开 filename_, 成功后才替换并关闭旧的 fd, 失败时旧的 fd 保持不变
+bool LogWriter::openFile() {
+    int fd = ::open(filename_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) return false;
+    if (fd_ != -1) close(fd_);
+    fd_ = fd;
+    // 续写已有的文件时, 按文件的大小和最后修改日期决定下一次何时切分
+    struct stat st{};
+    fstat(fd_, &st);
+    file_bytes_ = st.st_size;
+    file_day_ = localDay(st.st_size > 0 ? st.st_mtime : CachedClock::getInstance().wallTime());
+    header_bytes_ = 0;
+    if (file_header_) {
+        std::string header;
+        file_header_(header);
+        writeAll(header.data(), header.size());
+        if (st.st_size == 0) header_bytes_ = header.size();
+    }
+    return true;
+}
+
+// 只在写线程 (同步模式下由持有调用方锁的线程) 中调用, 每批记录检查一次
+bool LogWriter::rotateIfNeeded(size_t incoming) {
+    if (CachedClock::getInstance().wallTime() < rotate_retry_time_) return false;  // 上一次切分失败, 暂不重试
+    if (file_bytes_ <= header_bytes_) return false;  // 只有文件头的新文件不切分
+    bool new_day = rotation_.daily && localDay(CachedClock::getInstance().wallTime()) != file_day_;
+    bool too_large = rotation_.max_file_bytes > 0 && file_bytes_ + incoming > rotation_.max_file_bytes;
+    return (new_day || too_large) && rotate();
+}
+
+bool LogWriter::rotate() {
+    // 重命名为 "文件名.YYYY-MM-DD", 同一天内按大小切分时依次追加 .1 .2 ..., 序号只增不减, 即使旧文件已被删除
+    char date[16];
+    snprintf(date, sizeof(date), "%04d-%02d-%02d", file_day_ / 10000, file_day_ / 100 % 100, file_day_ % 100);
+    std::string base = filename_ + "." + date;
+    if (rotate_day_ != file_day_) {
+        // 进程重启或新的一天: 从已有的历史文件中找到最大的序号
+        rotate_day_ = file_day_;
+        rotate_index_ = -1;
+        for (auto& [mtime, path]: rotatedFiles()) {
+            if (path == base) {
+                rotate_index_ = std::max(rotate_index_, 0);
+            } else if (path.compare(0, base.size() + 1, base + ".") == 0) {
+                rotate_index_ = std::max(rotate_index_, std::atoi(path.c_str() + base.size() + 1));
+            }
+        }
+    }
+    ++ rotate_index_;
+    std::string target = rotate_index_ == 0 ? base : base + "." + std::to_string(rotate_index_);
+
+    // 切分失败时继续写原来的文件, 稍后再重试, 不能让写线程退出整个进程
+    if (rename(filename_.c_str(), target.c_str()) != 0) {
+        rotateFailed("rename to " + target);
+        return false;
+    }
+    if (!openFile()) {
+        int error = errno;
+        rename(target.c_str(), filename_.c_str());  // 旧的 fd 仍指向该文件, 改回原来的名字
+        errno = error;
+        rotateFailed("reopen");
+        return false;
+    }
+    rotate_retry_time_ = 0;
+    removeOldFiles();
+    return true;
+}
+
+void LogWriter::rotateFailed(const std::string& action) {
+    std::cerr << "Log rotation failed (" << action << "): " << filename_ << ": " << strerror(errno)
+              << ", retry in " << ROTATE_RETRY_SECONDS_ << "s\n";
+    -- rotate_index_;
+    rotate_retry_time_ = CachedClock::getInstance().wallTime() + ROTATE_RETRY_SECONDS_;
+}
+
+// 历史文件的后缀必须是 "YYYY-MM-DD" 或 "YYYY-MM-DD.N", 同名前缀的其他文件 (如 running.log.access) 不受影响
+bool LogWriter::isRotatedSuffix(std::string_view suffix) {
+    static constexpr std::string_view DATE_PATTERN = "0000-00-00";
+    if (suffix.size() < DATE_PATTERN.size()) return false;
+    for (size_t i = 0; i < DATE_PATTERN.size(); ++ i) {
+        bool digit = suffix[i] >= '0' && suffix[i] <= '9';
+        if (DATE_PATTERN[i] == '-' ? suffix[i] != '-' : !digit) return false;
+    }
+    suffix.remove_prefix(DATE_PATTERN.size());
+    if (suffix.empty()) return true;
+    if (suffix.size() < 2 || suffix[0] != '.') return false;
+    return std::all_of(suffix.begin() + 1, suffix.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+void LogWriter::removeOldFiles() {
+    if (rotation_.max_files == 0) return;
+    std::vector<std::pair<int64_t, std::string>> files = rotatedFiles();
+    if (files.size() <= rotation_.max_files) return;
+    std::sort(files.begin(), files.end());
+    for (size_t i = 0; i + rotation_.max_files < files.size(); ++ i) {
+        unlink(files[i].second.c_str());
+    }
+}
+
+std::vector<std::pair<int64_t, std::string>> LogWriter::rotatedFiles() const {
+    std::vector<std::pair<int64_t, std::string>> files;
+    size_t slash = filename_.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : filename_.substr(0, slash + 1);
+    std::string prefix = (slash == std::string::npos ? filename_ : filename_.substr(slash + 1)) + ".";
+
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) return files;
+    while (dirent* entry = readdir(d)) {
+        if (strncmp(entry->d_name, prefix.c_str(), prefix.size()) != 0 || !isRotatedSuffix(entry->d_name + prefix.size())) continue;
+        std::string path = (slash == std::string::npos ? "" : dir) + entry->d_name;
+        struct stat st{};
+        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) files.emplace_back(st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec, path);
+    }
+    closedir(d);
+    return files;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "log_ring.hpp"
+
+// 日志切分: 当前文件始终是 init 时指定的文件名, 切分时重命名为 "文件名.日期[.序号]"
+struct LogRotation {
+    size_t max_file_bytes = 0;  // 单个文件的最大字节数, 0 表示不按大小切分
+    bool daily = true;  // 日期变化时切分
+    size_t max_files = 0;  // 保留的历史文件数, 超出时删除最旧的, 0 表示全部保留
+};
+
+// 运行日志和访问日志共用的写入管道: 多生产者环形缓冲区 + 写线程 + 按日期和大小切分的输出文件.
+// 记录的编码方式由使用者提供, 写线程把一批记录编码到同一个缓冲区后一次写入
+class LogWriter {
+public:
+    using Encoder = std::function<void(const LogRing::Record& record, std::string& out)>;
+    using Appender = std::function<void(std::string& out)>;
+
+    explicit LogWriter(size_t capacity);
+    ~LogWriter();
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    // 以下在 open 之前调用
+    void setRotation(const LogRotation& rotation) { rotation_ = rotation; }
+    void setEncoder(Encoder encode) { encode_ = std::move(encode); }
+    void setFileHeader(Appender header) { file_header_ = std::move(header); }  // 每个新文件开头写入的内容, 同时用于重置编码状态
+    void setBatchTrailer(Appender trailer) { batch_trailer_ = std::move(trailer); }  // 每批记录之后追加的内容
+
+    bool open(const std::string& filename);  // 只在初始化时调用, 失败时返回 false 并保留 errno
+    void start();  // 启动写线程
+    void stop();  // 写完已发布的记录后停止写线程
+
+    // 生产者
+    LogRing::Record* tryClaim() { return ring_.tryClaim(); }
+    void publish(LogRing::Record* record);
+    void wake();
+
+    void writeRecord(const LogRing::Record& record);  // 不启动写线程时的同步写入, 调用方负责串行化
+    bool running() const { return running_.load(); }
+    bool pending() { return ring_.peek(0) != nullptr; }  // 还有未写入的记录
+    size_t queueDepth() const { return ring_.size(); }
+
+private:
+    static constexpr size_t MAX_BATCH_ = 256;  // 写线程一次 write 最多合并的记录数
+    static constexpr time_t ROTATE_RETRY_SECONDS_ = 60;
+
+    void writeLoop();
+    void encodeBatch(size_t count);
+    void writeAll(const char* data, size_t size);
+    bool openFile();
+    bool rotateIfNeeded(size_t incoming);  // 发生切分时返回 true
+    bool rotate();
+    void rotateFailed(const std::string& action);  // 报告切分失败, 推迟下一次重试
+    static bool isRotatedSuffix(std::string_view suffix);
+    void removeOldFiles();
+    std::vector<std::pair<int64_t, std::string>> rotatedFiles() const;  // 所有历史文件 (修改时间 ns, 路径)
+    static int localDay(time_t time);  // 本地日期, 如 20250624
+
+    LogRing ring_;
+    Encoder encode_;
+    Appender file_header_;
+    Appender batch_trailer_;
+
+    // 以下只由写线程 (同步模式下由持有调用方锁的线程) 访问
+    int fd_;  // 切分时会被替换
+    std::string filename_;
+    LogRotation rotation_;
+    size_t file_bytes_;  // 当前文件的大小
+    size_t header_bytes_ = 0;  // 新文件中文件头的大小
+    int file_day_;  // 当前文件内容所属的日期
+    int rotate_day_;  // rotate_index_ 对应的日期
+    int rotate_index_;  // 该日期最后一个历史文件的序号, -1 表示还没有
+    time_t rotate_retry_time_;  // 切分失败后, 在此之前不再重试
+    std::string batch_;  // 一批记录编码后的内容
+
+    std::thread write_thread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> writer_sleeping_;
+    std::atomic<uint32_t> wake_seq_;  // 写线程在上面等待新记录
+};
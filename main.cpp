@@ -1,14 +1,105 @@
 #include <iostream>
+#include <csignal>
+#include <cstring>
+#include <getopt.h>
 #include "server.hpp"
 #include "log/log.hpp"
+#include "log/access_log.hpp"
+#include "metrics/trace.hpp"
 
-int main() {
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-p port] [-m pool|reactor] [-n loops] [-d rr|least] [-s] [-a] [-t heap|wheel] [-l level] [-r MB] [-k files] [-A file] [-c conns] [-T ms]\n"
+              << "  -p  监听端口, 默认 8080\n"
+              << "  -m  pool: 单 epoll + 线程池 (默认); reactor: 主从 reactor, 每个子 reactor 一个 epoll\n"
+              << "  -n  reactor 模式下子 reactor 的数量, 默认为 CPU 核数\n"
+              << "  -d  reactor 模式下新连接的分配方式, rr: 轮询 (默认); least: 连接数最少优先\n"
+              << "  -s  每个子 reactor 一个 SO_REUSEPORT 监听 socket, 由内核分配新连接 (隐含 -m reactor)\n"
+              << "  -a  把每个子 reactor 线程绑定到一个 CPU\n"
+              << "  -t  连接超时定时器, heap: 小根堆 (默认); wheel: 分层时间轮\n"
+              << "  -l  最低日志级别, debug / info (默认) / warning / error\n"
+              << "  -r  日志文件超过该大小 (MB) 时切分, 默认 100, 0 表示只按天切分\n"
+              << "  -k  保留的历史日志文件数, 默认 7, 0 表示全部保留\n"
+              << "  -A  把每个请求的二进制访问记录写入该文件, 用 access_log_decode 查看, 与运行日志一样按 -r/-k 切分\n"
+              << "  -c  MySQL 连接池大小和数据库线程数, 默认 8\n"
+              << "  -T  记录各阶段耗时, 总耗时超过该值 (ms) 的请求写入日志并可从 /traces 导出, 默认关闭\n";
+}
+
+int main(int argc, char* argv[]) {
+    signal(SIGPIPE, SIG_IGN);  // writev/sendfile 无法传 MSG_NOSIGNAL, 对端关闭时忽略 SIGPIPE
+
+    ServerConfig config;
+    LogLevel log_level = LogLevel::INFO;
+    const char* access_log = nullptr;
+    LogRotation rotation;
+    rotation.max_file_bytes = 100 * 1024 * 1024;
+    rotation.max_files = 7;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:m:n:d:t:l:r:k:A:c:T:sah")) != -1) {
+        switch (opt) {
+            case 'p':
+                config.port = std::atoi(optarg);
+                break;
+            case 'm':
+                config.mode = (strcmp(optarg, "reactor") == 0) ? ServerConfig::Mode::MULTI_REACTOR : ServerConfig::Mode::THREAD_POOL;
+                break;
+            case 'n':
+                config.loop_count = std::atoi(optarg);
+                break;
+            case 'd':
+                config.dispatch = (strcmp(optarg, "least") == 0) ? ServerConfig::Dispatch::LEAST_LOADED : ServerConfig::Dispatch::ROUND_ROBIN;
+                break;
+            case 's':
+                config.mode = ServerConfig::Mode::MULTI_REACTOR;
+                config.reuse_port = true;
+                break;
+            case 'a':
+                config.pin_cpu = true;
+                break;
+            case 't':
+                config.timer = (strcmp(optarg, "wheel") == 0) ? TimerType::WHEEL : TimerType::HEAP;
+                break;
+            case 'l':
+                if (strcmp(optarg, "debug") == 0) {
+                    log_level = LogLevel::DEBUG;
+                } else if (strcmp(optarg, "warning") == 0) {
+                    log_level = LogLevel::WARNING;
+                } else if (strcmp(optarg, "error") == 0) {
+                    log_level = LogLevel::ERROR;
+                }
+                break;
+            case 'r':
+                rotation.max_file_bytes = static_cast<size_t>(std::atol(optarg)) * 1024 * 1024;
+                break;
+            case 'k':
+                rotation.max_files = static_cast<size_t>(std::atol(optarg));
+                break;
+            case 'A':
+                access_log = optarg;
+                break;
+            case 'c':
+                config.sql.pool_size = static_cast<size_t>(std::atol(optarg));
+                break;
+            case 'T':
+                Tracer::getInstance().setSlowThreshold(static_cast<int64_t>(std::atof(optarg) * 1000));
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    Logger::getInstance().setRotation(rotation);
     Logger::getInstance().init("running.log", true);
+    Logger::getInstance().setLevel(log_level);
+    if (access_log) {
+        AccessLog::getInstance().setRotation(rotation);  // 与运行日志使用相同的切分规则
+        AccessLog::getInstance().init(access_log);
+    }
     std::cout << "Server started" << std::endl;
-    Logger::getInstance().log("INFO", "Server started");
+    LOG_INFO("Server started");
 
-    WebServer server(8080);
+    WebServer server(config);
     server.run();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,144 @@
+#include "metrics.hpp"
+
+#include <cstdio>
+
+Metrics& Metrics::getInstance() {
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::Shard* Metrics::registerShard() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_.push_back(std::make_unique<Shard>());
+    return shards_.back().get();
+}
+
+void Metrics::countStatus(int status) {
+    if (status < MIN_STATUS_ || status >= MAX_STATUS_) return;
+    bump(shard().status[status - MIN_STATUS_], 1);
+}
+
+void Metrics::observe(Histogram histogram, uint64_t ns) {
+    const uint64_t* bounds = BUCKETS_[static_cast<int>(histogram)];
+    HistogramShard& h = shard().histograms[static_cast<int>(histogram)];
+    size_t i = 0;
+    while (i < BOUND_COUNT_ && ns > bounds[i]) ++ i;
+    bump(h.buckets[i], 1);
+    bump(h.sum, ns);
+    bump(h.count, 1);
+}
+
+void Metrics::addGauge(const std::string& name, const std::string& help, std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauges_.push_back({name, help, std::move(read)});
+}
+
+static void header(std::string& out, const char* name, const char* help, const char* type) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+static void sample(std::string& out, const char* name, const char* labels, uint64_t value) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s%s %llu\n", name, labels, static_cast<unsigned long long>(value));
+    out += buf;
+}
+
+static void sample(std::string& out, const char* name, const char* labels, double value) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s%s %.9g\n", name, labels, value);
+    out += buf;
+}
+
+std::string Metrics::render() {
+    constexpr int COUNTERS = static_cast<int>(Counter::COUNT);
+    constexpr int HISTOGRAMS = static_cast<int>(Histogram::COUNT);
+    constexpr int STATUSES = MAX_STATUS_ - MIN_STATUS_;
+
+    // 汇总所有线程的分片, 各分片的值是单独读取的, 彼此之间不保证是同一时刻的快照
+    uint64_t counters[COUNTERS] = {};
+    std::vector<uint64_t> status(STATUSES, 0);
+    uint64_t buckets[HISTOGRAMS][BUCKET_COUNT_] = {};
+    uint64_t sums[HISTOGRAMS] = {};
+    uint64_t counts[HISTOGRAMS] = {};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& shard: shards_) {
+        for (int i = 0; i < COUNTERS; ++ i) counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+        for (int i = 0; i < STATUSES; ++ i) status[i] += shard->status[i].load(std::memory_order_relaxed);
+        for (int h = 0; h < HISTOGRAMS; ++ h) {
+            HistogramShard& hs = shard->histograms[h];
+            for (size_t b = 0; b < BUCKET_COUNT_; ++ b) buckets[h][b] += hs.buckets[b].load(std::memory_order_relaxed);
+            sums[h] += hs.sum.load(std::memory_order_relaxed);
+            counts[h] += hs.count.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::string out;
+    out.reserve(8192);
+    header(out, "webserver_accepts_total", "Accepted client connections.", "counter");
+    sample(out, "webserver_accepts_total", "", counters[static_cast<int>(Counter::ACCEPTS)]);
+
+    uint64_t closed_request = counters[static_cast<int>(Counter::CLOSED_BY_REQUEST)];
+    uint64_t closed_timeout = counters[static_cast<int>(Counter::CLOSED_BY_TIMEOUT)];
+    uint64_t closed_error = counters[static_cast<int>(Counter::CLOSED_BY_ERROR)];
+    header(out, "webserver_connections_closed_total", "Closed client connections by reason.", "counter");
+    sample(out, "webserver_connections_closed_total", "{reason=\"request\"}", closed_request);
+    sample(out, "webserver_connections_closed_total", "{reason=\"timeout\"}", closed_timeout);
+    sample(out, "webserver_connections_closed_total", "{reason=\"error\"}", closed_error);
+
+    // 由计数器推算, 不需要在请求路径上维护一个共享的 gauge
+    uint64_t closed = closed_request + closed_timeout + closed_error;
+    uint64_t accepts = counters[static_cast<int>(Counter::ACCEPTS)];
+    header(out, "webserver_active_connections", "Currently open client connections.", "gauge");
+    sample(out, "webserver_active_connections", "", accepts > closed ? accepts - closed : uint64_t(0));
+
+    header(out, "webserver_sent_bytes_total", "Bytes written to client sockets.", "counter");
+    sample(out, "webserver_sent_bytes_total", "", counters[static_cast<int>(Counter::BYTES_SENT)]);
+    header(out, "webserver_timer_expirations_total", "Idle connections returned by the timer tick.", "counter");
+    sample(out, "webserver_timer_expirations_total", "", counters[static_cast<int>(Counter::TIMER_EXPIRATIONS)]);
+
+    header(out, "webserver_requests_total", "Responses by HTTP status code.", "counter");
+    for (int i = 0; i < STATUSES; ++ i) {
+        if (status[i] == 0) continue;
+        char labels[32];
+        snprintf(labels, sizeof(labels), "{code=\"%d\"}", i + MIN_STATUS_);
+        sample(out, "webserver_requests_total", labels, status[i]);
+    }
+
+    static const char* const names[HISTOGRAMS][2] = {
+        {"webserver_request_duration_seconds", "Time from a parsed request to its queued response."},
+        {"webserver_parse_duration_seconds", "Time of the parse call that completes a request."},
+        {"webserver_send_duration_seconds", "Time of one flush of the output queue."}
+    };
+    for (int h = 0; h < HISTOGRAMS; ++ h) {
+        std::string name = names[h][0];
+        header(out, name.c_str(), names[h][1], "histogram");
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < BUCKET_COUNT_; ++ b) {
+            cumulative += buckets[h][b];
+            char labels[48];
+            if (b + 1 < BUCKET_COUNT_) {
+                snprintf(labels, sizeof(labels), "{le=\"%g\"}", BUCKETS_[h][b] / 1e9);
+            } else {
+                snprintf(labels, sizeof(labels), "{le=\"+Inf\"}");
+            }
+            sample(out, (name + "_bucket").c_str(), labels, cumulative);
+        }
+        sample(out, (name + "_sum").c_str(), "", sums[h] / 1e9);
+        sample(out, (name + "_count").c_str(), "", counts[h]);
+    }
+
+    for (const Gauge& gauge: gauges_) {
+        header(out, gauge.name.c_str(), gauge.help.c_str(), "gauge");
+        sample(out, gauge.name.c_str(), "", gauge.read());
+    }
+    return out;
+}
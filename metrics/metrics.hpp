@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 计数器, 只增不减
+enum class Counter {
+    ACCEPTS,  // 建立的连接
+    CLOSED_BY_REQUEST,  // Connection: close 或对端关闭
+    CLOSED_BY_TIMEOUT,
+    CLOSED_BY_ERROR,
+    BYTES_SENT,  // 写入 socket 的字节数
+    TIMER_EXPIRATIONS,  // 定时器 tick 取出的到期连接
+    COUNT
+};
+
+// 直方图, 单位为纳秒, 由单调时钟测量
+enum class Histogram {
+    REQUEST_LATENCY,  // 解析完成到响应加入发送队列, 包括等待数据库的时间
+    PARSE_TIME,  // 完成一个请求的那次 parse 调用
+    SEND_TIME,  // 一次 flushOutput
+    COUNT
+};
+
+// 按线程分片的指标. 每个线程只写自己的分片 (普通的 load + store, 没有锁和原子读改写),
+// 读取 /metrics 时才遍历所有分片求和, 生成 Prometheus 文本格式
+class Metrics {
+public:
+    static Metrics& getInstance();
+
+    static void add(Counter counter, uint64_t n = 1) { bump(shard().counters[static_cast<int>(counter)], n); }
+    static void countStatus(int status);  // 按状态码统计请求数
+    static void observe(Histogram histogram, uint64_t ns);
+
+    // 注册一个在导出时读取的瞬时值 (队列长度等), 回调必须线程安全, 且不能再记录指标
+    void addGauge(const std::string& name, const std::string& help, std::function<double()> read);
+    std::string render();
+
+private:
+    // 各直方图的上界 (纳秒), 最后还有一个 +Inf 桶. 解析耗时通常不到 1 微秒, 使用更细的桶
+    static constexpr size_t BOUND_COUNT_ = 15;
+    static constexpr size_t BUCKET_COUNT_ = BOUND_COUNT_ + 1;
+    static constexpr uint64_t BUCKETS_[static_cast<int>(Histogram::COUNT)][BOUND_COUNT_] = {
+        {50'000, 100'000, 250'000, 500'000, 1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000,
+         100'000'000, 250'000'000, 500'000'000, 1'000'000'000, 2'500'000'000},
+        {100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000, 1'000'000, 2'500'000, 5'000'000},
+        {50'000, 100'000, 250'000, 500'000, 1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000,
+         100'000'000, 250'000'000, 500'000'000, 1'000'000'000, 2'500'000'000}
+    };
+    static constexpr int MIN_STATUS_ = 100;
+    static constexpr int MAX_STATUS_ = 600;
+
+    struct HistogramShard {
+        std::atomic<uint64_t> buckets[BUCKET_COUNT_] = {};  // 非累计, 导出时再累加
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> count{0};
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counters[static_cast<int>(Counter::COUNT)] = {};
+        std::atomic<uint64_t> status[MAX_STATUS_ - MIN_STATUS_] = {};
+        HistogramShard histograms[static_cast<int>(Histogram::COUNT)];
+    };
+
+    struct Gauge {
+        std::string name;
+        std::string help;
+        std::function<double()> read;
+    };
+
+    Metrics() = default;
+
+    // 只有一个线程写, 不需要 fetch_add
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static Shard& shard() {
+        thread_local Shard* shard = getInstance().registerShard();
+        return *shard;
+    }
+    Shard* registerShard();
+
+    std::mutex mutex_;  // 保护 shards_ 和 gauges_, 只在线程第一次记录和导出时使用
+    std::vector<std::unique_ptr<Shard>> shards_;  // 线程退出后分片保留, 计数不会丢失
+    std::vector<Gauge> gauges_;
+};
@@ -0,0 +1,121 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "../log/log.hpp"
+
+static const char* const STAGE_NAMES[] = {"queue", "recv", "parse", "handle", "db", "send"};
+
+static void copyTruncated(char* dst, size_t size, std::string_view src) {
+    size_t n = std::min(src.size(), size - 1);
+    memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+void RequestTrace::setRequest(std::string_view request_method, std::string_view request_path) {
+    copyTruncated(method, sizeof(method), request_method);
+    copyTruncated(path, sizeof(path), request_path);
+}
+
+int64_t RequestTrace::beginNs() const {
+    int64_t begin = 0;
+    for (int i = 0; i < STAGES; ++ i) {
+        if (start_ns[i] != 0 && (begin == 0 || start_ns[i] < begin)) begin = start_ns[i];
+    }
+    return begin;
+}
+
+int64_t RequestTrace::endNs() const {
+    int64_t end = 0;
+    for (int i = 0; i < STAGES; ++ i) end = std::max(end, end_ns[i]);
+    return end;
+}
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Ring& Tracer::ring() {
+    thread_local Ring* ring = [this] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.push_back(std::make_unique<Ring>());
+        rings_.back()->traces.resize(RING_SIZE_);
+        rings_.back()->tid = syscall(SYS_gettid);
+        return rings_.back().get();
+    }();
+    return *ring;
+}
+
+void Tracer::finish(const RequestTrace& trace) {
+    int64_t total = trace.endNs() - trace.beginNs();
+    if (threshold_ns_ < 0 || total < threshold_ns_) return;
+
+    Ring& r = ring();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.traces[r.next % RING_SIZE_] = trace;
+        ++ r.next;
+    }
+
+    double stages[RequestTrace::STAGES];
+    for (int i = 0; i < RequestTrace::STAGES; ++ i) stages[i] = (trace.end_ns[i] - trace.start_ns[i]) / 1e6;
+    LOG_WARNING("Slow request fd={} {} {} {} took {} ms (queue {} recv {} parse {} handle {} db {} send {})",
+                trace.fd, trace.method, trace.path, trace.status, total / 1e6,
+                stages[0], stages[1], stages[2], stages[3], stages[4], stages[5]);
+}
+
+// JSON 字符串转义, 路径来自客户端
+static void appendJsonString(std::string& out, const char* s) {
+    out += '"';
+    for (; *s; ++ s) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+std::string Tracer::exportChromeTrace() {
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char buf[256];
+    auto event = [&](const RequestTrace& trace, long tid, const char* name, int64_t start, int64_t end) {
+        if (!first) out += ',';
+        first = false;
+        snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"cat\":\"request\",\"ph\":\"X\",\"pid\":%d,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"fd\":%d,\"status\":%d,\"method\":",
+                 name, static_cast<int>(getpid()), tid, start / 1e3, (end - start) / 1e3, trace.fd, trace.status);
+        out += buf;
+        appendJsonString(out, trace.method);
+        out += ",\"path\":";
+        appendJsonString(out, trace.path);
+        out += "}}";
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& r: rings_) {
+        std::lock_guard<std::mutex> ring_lock(r->mutex);
+        size_t count = std::min(r->next, RING_SIZE_);
+        for (size_t i = 0; i < count; ++ i) {
+            const RequestTrace& trace = r->traces[i];
+            // 整个请求一个事件, 各阶段嵌套在其中
+            event(trace, r->tid, "request", trace.beginNs(), trace.endNs());
+            for (int s = 0; s < RequestTrace::STAGES; ++ s) {
+                if (trace.start_ns[s] != 0) event(trace, r->tid, STAGE_NAMES[s], trace.start_ns[s], trace.end_ns[s]);
+            }
+        }
+    }
+    out += "]}\n";
+    return out;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 请求处理的各个阶段
+enum class TraceStage {
+    QUEUE,  // 线程池模式下从分发到工作线程开始处理
+    RECV,  // 读取 socket (同一批 pipelined 请求共享)
+    PARSE,
+    HANDLE,  // 路由、查找文件、生成响应头
+    DB,  // 从提交数据库请求到结果返回
+    SEND,  // 从响应加入发送队列到全部写入 socket
+    COUNT
+};
+
+// 一个请求在各阶段的起止时间 (steady_clock, ns), 为 0 表示没有经过该阶段
+struct RequestTrace {
+    static constexpr int STAGES = static_cast<int>(TraceStage::COUNT);
+
+    int64_t start_ns[STAGES] = {};
+    int64_t end_ns[STAGES] = {};
+    int fd = -1;
+    int status = 0;
+    char method[8] = {};
+    char path[64] = {};  // 超出的部分被截断
+
+    void mark(TraceStage stage, int64_t start, int64_t end) {
+        start_ns[static_cast<int>(stage)] = start;
+        end_ns[static_cast<int>(stage)] = end;
+    }
+    void setRequest(std::string_view method, std::string_view path);
+    int64_t beginNs() const;  // 最早的阶段开始时间
+    int64_t endNs() const;
+};
+
+// 慢请求追踪. 每个请求的时间戳记录在连接自己的 RequestTrace 中, 请求完成时总耗时超过阈值才写入
+// 当前线程的环形缓冲 (每个线程一个, 只有导出时才会有其他线程读取), 同时记一条 WARNING 日志.
+// 导出为 Chrome trace-event JSON, 可以直接在 chrome://tracing 或 Perfetto 中打开
+class Tracer {
+public:
+    static Tracer& getInstance();
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void setSlowThreshold(int64_t us) { threshold_ns_ = us * 1000; }  // 在启动时调用, 小于 0 表示关闭
+    bool enabled() const { return threshold_ns_ >= 0; }
+
+    void finish(const RequestTrace& trace);
+    std::string exportChromeTrace();  // 所有线程中保存的慢请求
+
+private:
+    static constexpr size_t RING_SIZE_ = 1024;  // 每个线程保存最近的慢请求数
+
+    struct Ring {
+        std::mutex mutex;  // 写入只发生在慢请求上, 平时没有竞争
+        std::vector<RequestTrace> traces;
+        size_t next = 0;
+        long tid = 0;
+    };
+
+    Tracer() = default;
+    Ring& ring();
+
+    int64_t threshold_ns_ = -1;
+    std::mutex mutex_;  // 保护 rings_
+    std::vector<std::unique_ptr<Ring>> rings_;
+};
@@ -1,16 +1,24 @@
 #include "ThreadPool.hpp"
 
+// 当前线程在所属线程池中的序号, 用于把工作线程自己提交的任务放入自己的队列
+static thread_local const ThreadPool* tls_pool = nullptr;
+static thread_local size_t tls_index = 0;
+
 ThreadPool::ThreadPool(size_t threadCount) : stop_(false) {
     for (size_t i = 0; i < threadCount; ++ i) {
-        workers_.emplace_back([this]() {
-            this->worker();
+        queues_.emplace_back(std::make_unique<LockFreeQueue<Task>>(QUEUE_CAPACITY_));
+    }
+    for (size_t i = 0; i < threadCount; ++ i) {
+        workers_.emplace_back([this, i]() {
+            this->worker(i);
         });
     }
 }
 
 ThreadPool::~ThreadPool() {
     stop_.store(true);
-    cv_.notify_all();
+    epoch_.fetch_add(1);
+    epoch_.notify_all();
     for (std::thread& worker: workers_) {
         if (worker.joinable()) {
             worker.join();
@@ -19,28 +27,80 @@ ThreadPool::~ThreadPool() {
 }
 
 void ThreadPool::enqueue(const std::function<void()>& task) {
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        tasks.emplace(task);
+    submit(task);
+}
+
+void ThreadPool::submitBatch(std::vector<Task>& tasks) {
+    for (Task& task: tasks) push(task);
+    notify(tasks.size());
+    tasks.clear();
+}
+
+size_t ThreadPool::pendingTasks() const {
+    size_t total = 0;
+    for (auto& queue: queues_) total += queue->size();
+    return total;
+}
+
+void ThreadPool::push(Task& task) {
+    size_t count = queues_.size();
+    size_t start = (tls_pool == this) ? tls_index : next_queue_.fetch_add(1, std::memory_order_relaxed);
+    while (true) {
+        for (size_t i = 0; i < count; ++ i) {
+            if (queues_[(start + i) % count]->tryPush(task)) return;
+        }
+        std::this_thread::yield();  // 所有队列都满了, 等工作线程消费
     }
-    cv_.notify_one();
 }
 
-void ThreadPool::worker() {
-    while (!stop_.load()) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            cv_.wait(lock, [this]() {
-                return stop_.load() || !tasks.empty();
-            });
+bool ThreadPool::tryPop(size_t index, Task& task) {
+    if (queues_[index]->tryPop(task)) return true;
+    // 自己的队列为空, 从其他线程的队列中窃取
+    size_t count = queues_.size();
+    for (size_t i = 1; i < count; ++ i) {
+        if (queues_[(index + i) % count]->tryPop(task)) return true;
+    }
+    return false;
+}
+
+void ThreadPool::notify(size_t count) {
+    epoch_.fetch_add(1);
+    if (sleepers_.load() == 0) return;
+    if (count == 1) {
+        epoch_.notify_one();
+    } else {
+        epoch_.notify_all();
+    }
+}
 
-            if (stop_.load() && tasks.empty()) return;
+void ThreadPool::worker(size_t index) {
+    tls_pool = this;
+    tls_index = index;
 
-            task = std::move(tasks.front());
-            tasks.pop();
+    Task task;
+    while (true) {
+        bool found = false;
+        for (int spin = 0; spin < SPIN_COUNT_ && !found; ++ spin) {
+            found = tryPop(index, task);
+            if (!found) std::this_thread::yield();
         }
+        if (found) {
+            task();  // 执行任务
+            task = Task();
+            continue;
+        }
+
+        // 先记下 epoch 再检查一次队列, 避免错过检查之后、休眠之前提交的任务
+        uint32_t epoch = epoch_.load();
+        if (tryPop(index, task)) {
+            task();
+            task = Task();
+            continue;
+        }
+        if (stop_.load()) return;
 
-        task();  // 执行任务
+        ++ sleepers_;
+        epoch_.wait(epoch);
+        -- sleepers_;
     }
-}
\ No newline at end of file
+}
@@ -7,7 +7,88 @@
 #include <condition_variable>
 #include <functional>
 #include <atomic>
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "lockfree_queue.hpp"
 
+// 只能移动的任务对象, 可调用对象直接保存在内部缓冲区中, 不分配堆内存
+class Task {
+public:
+    static constexpr size_t STORAGE_SIZE = 48;
+
+    Task() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= STORAGE_SIZE, "task is too large, capture less state");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "task is over-aligned");
+        static_assert(std::is_nothrow_move_constructible_v<Fn>, "task must be nothrow movable");
+        new (storage_) Fn(std::forward<F>(f));
+        ops_ = &OpsFor<Fn>::ops;
+    }
+
+    Task(Task&& other) noexcept { moveFrom(other); }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    void operator()() { ops_->invoke(storage_); }
+    explicit operator bool() const { return ops_ != nullptr; }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);  // 移动构造到 dst 并析构 src
+        void (*destroy)(void*);
+    };
+
+    template<typename Fn>
+    struct OpsFor {
+        static constexpr Ops ops = {
+            [](void* p) { (*static_cast<Fn*>(p))(); },
+            [](void* dst, void* src) {
+                new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+                static_cast<Fn*>(src)->~Fn();
+            },
+            [](void* p) { static_cast<Fn*>(p)->~Fn(); }
+        };
+    };
+
+    void moveFrom(Task& other) {
+        ops_ = other.ops_;
+        if (ops_) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[STORAGE_SIZE];
+    const Ops* ops_ = nullptr;
+};
+
+// 工作窃取线程池: 每个工作线程有一个有界无锁队列, 提交的任务轮流分配到各个队列,
+// 工作线程先取自己队列中的任务, 自己的队列为空时从其他线程的队列中窃取
 class ThreadPool {
 public:
     ThreadPool(size_t threadCount = 4);
@@ -16,11 +97,32 @@ public:
     // 添加任务到线程池
     void enqueue(const std::function<void()>& task);
 
+    template<typename F>
+    void submit(F&& f) {
+        Task task(std::forward<F>(f));
+        push(task);
+        notify(1);
+    }
+
+    // 批量提交, 所有任务入队之后只唤醒一次
+    void submitBatch(std::vector<Task>& tasks);
+
+    // 所有队列中等待执行的任务数 (近似值)
+    size_t pendingTasks() const;
+
 private:
-    void worker();
+    static constexpr size_t QUEUE_CAPACITY_ = 1024;  // 每个工作线程队列的容量
+    static constexpr int SPIN_COUNT_ = 64;  // 休眠之前自旋查找任务的次数
+
+    void worker(size_t index);
+    void push(Task& task);
+    bool tryPop(size_t index, Task& task);
+    void notify(size_t count);
+
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks;
-    std::mutex mutex_;
-    std::condition_variable cv_;
+    std::vector<std::unique_ptr<LockFreeQueue<Task>>> queues_;
+    std::atomic<size_t> next_queue_{0};  // 轮流分配的下一个队列
+    std::atomic<uint32_t> epoch_{0};  // 每次提交后递增, 空闲线程在上面等待
+    std::atomic<int> sleepers_{0};
     std::atomic<bool> stop_;
-};
\ No newline at end of file
+};
@@ -0,0 +1,241 @@
+#include "EventLoop.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include "../log/log.hpp"
+
+EventLoop::EventLoop(int id, MySQLConnector* mysql, DBExecutor* db, TimerType timer_type) : id_(id), listen_fd_(-1), mysql_(mysql), db_(db), clients_(mysql), timer_(createTimer(timer_type)),
+    clock_(id == 0 ? &CachedClock::global() : &own_clock_), running_(false), conn_count_(0) {
+    epoll_fd_ = epoll_create1(0);
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ == -1 || wakeup_fd_ == -1) {
+        perror("event loop creation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    epoll_event event{};
+    event.data.u64 = ConnectionSlab::makeKey(wakeup_fd_, 0);
+    event.events = EPOLLIN;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event);
+}
+
+EventLoop::~EventLoop() {
+    stop();
+    clients_.forEachOpen([](int fd) { close(fd); });
+    if (listen_fd_ != -1) close(listen_fd_);
+    close(wakeup_fd_);
+    close(epoll_fd_);
+}
+
+void EventLoop::start(int cpu) {
+    if (listen_fd_ != -1) {
+        epoll_event event{};
+        event.data.u64 = ConnectionSlab::makeKey(listen_fd_, 0);
+        event.events = EPOLLIN | EPOLLET;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+    }
+
+    running_ = true;
+    thread_ = std::thread(&EventLoop::loop, this);
+
+    if (cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        if (pthread_setaffinity_np(thread_.native_handle(), sizeof(cpuset), &cpuset) != 0) {
+            LOG_WARNING("Cannot pin event loop {} to CPU {}", id_, cpu);
+        }
+    }
+}
+
+void EventLoop::stop() {
+    running_ = false;
+    wakeup();
+    join();
+}
+
+void EventLoop::join() {
+    if (thread_.joinable()) thread_.join();
+}
+
+void EventLoop::addConnection(int client_fd) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_fds_.push_back(client_fd);
+    }
+    conn_count_.fetch_add(1, std::memory_order_relaxed);
+    wakeup();
+}
+
+void EventLoop::queueInLoop(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_tasks_.push_back(std::move(task));
+    }
+    wakeup();
+}
+
+void EventLoop::wakeup() {
+    uint64_t one = 1;
+    ssize_t n = write(wakeup_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void EventLoop::handleWakeup() {
+    uint64_t count;
+    while (read(wakeup_fd_, &count, sizeof(count)) > 0) {}
+
+    // 与 pending_ 交换后各自保留容量, 之后的 addConnection 不需要再分配内存
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        ready_fds_.swap(pending_fds_);
+        ready_tasks_.swap(pending_tasks_);
+    }
+
+    for (int client_fd: ready_fds_) registerConnection(client_fd);
+    for (auto& task: ready_tasks_) task();
+    ready_fds_.clear();
+    ready_tasks_.clear();
+}
+
+void EventLoop::acceptConnections() {
+    // 接收新连接, 持续接收, 直至没有新的连接到达
+    while (true) {
+        sockaddr_in client_addr{};
+        socklen_t client_len = sizeof(client_addr);
+        int client_fd = accept4(listen_fd_, (sockaddr*)&client_addr, &client_len, SOCK_NONBLOCK);
+        if (client_fd < 0) break;
+
+        conn_count_.fetch_add(1, std::memory_order_relaxed);
+        registerConnection(client_fd);
+    }
+}
+
+void EventLoop::registerConnection(int client_fd) {
+    if (clients_.open(client_fd) == nullptr) {
+        LOG_ERROR("Client[{}] exceeds the connection table, closed (loop {})", client_fd, id_);
+        close(client_fd);
+        conn_count_.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    timer_->addTimer(client_fd, MAX_TIMEOUT_);  // 给client_fd添加定时器
+    Metrics::add(Counter::ACCEPTS);
+    LOG_INFO("Client[{}] in! (loop {})", client_fd, id_);
+
+    epoll_event event{};
+    event.data.u64 = clients_.key(client_fd);
+    event.events = EPOLLIN | EPOLLET;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &event);
+}
+
+void EventLoop::loop() {
+    epoll_event events[MAX_EVENTS_];
+    std::vector<int> expired_fds;
+    clock_->bindToThread();  // 本线程的定时器、日志和响应头都读取这个时钟
+
+    while (running_) {
+        int timeout = timer_->getNextTick();
+        int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS_, timeout);
+        clock_->update();  // 本轮的事件处理、定时器和日志都使用这个时间
+        if (nfds == -1) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            break;
+        }
+
+        for (int i = 0; i < nfds; ++ i) {
+            uint64_t key = events[i].data.u64;
+            int fd = ConnectionSlab::fdOf(key);
+            if (fd == wakeup_fd_) {
+                handleWakeup();
+                continue;
+            }
+            if (fd == listen_fd_) {
+                acceptConnections();
+                continue;
+            }
+
+            // 本轮中已被关闭, 或者 fd 已被本轮中建立的新连接复用
+            HTTPConnection* conn_ptr = clients_.findByKey(key);
+            if (conn_ptr == nullptr) continue;
+            HTTPConnection& conn = *conn_ptr;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                applyAction(fd, conn, conn.onReadable());
+            } else if (events[i].events & EPOLLOUT) {
+                applyAction(fd, conn, conn.onWritable());
+            }
+        }
+
+        expired_fds.clear();
+        timer_->tick(expired_fds);
+        if (!expired_fds.empty()) Metrics::add(Counter::TIMER_EXPIRATIONS, expired_fds.size());
+        for (int fd: expired_fds) {
+            HTTPConnection* conn = clients_.find(fd);
+            if (conn != nullptr) {
+                LOG_INFO("Client[{}] is closed due to timeout, and it is used {} times.", fd, conn->use_count);
+                Metrics::add(Counter::CLOSED_BY_TIMEOUT);
+                closeClient(fd);
+            }
+        }
+    }
+}
+
+void EventLoop::applyAction(int client_fd, HTTPConnection& conn, HTTPConnection::Action action) {
+    switch (action) {
+        case HTTPConnection::Action::WAIT_READ:
+        case HTTPConnection::Action::WAIT_WRITE:
+            updateEvents(client_fd, conn, action == HTTPConnection::Action::WAIT_WRITE);
+            timer_->updateTimer(client_fd, MAX_TIMEOUT_);
+            break;
+        case HTTPConnection::Action::WAIT_DB:
+            // 等待期间照常收发数据, 但不处理新的请求. 结果经 eventfd 投递回本线程
+            if (auto query = conn.takeDBQuery()) {
+                uint64_t key = clients_.key(client_fd);
+                db_->submit(std::move(query), [this, key](bool success) {
+                    queueInLoop([this, key, success] { onDBComplete(key, success); });
+                });
+            }
+            updateEvents(client_fd, conn, conn.hasPendingOutput());
+            timer_->updateTimer(client_fd, MAX_TIMEOUT_);
+            break;
+        case HTTPConnection::Action::CLOSE:
+            LOG_INFO("Client[{}] is closed due to http request, and it is used {} times.", client_fd, conn.use_count);
+            Metrics::add(Counter::CLOSED_BY_REQUEST);
+            closeClient(client_fd);
+            break;
+        case HTTPConnection::Action::ERROR:
+            LOG_ERROR("Client[{}] is closed due to network error or read error, and it is used {} times.", client_fd, conn.use_count);
+            Metrics::add(Counter::CLOSED_BY_ERROR);
+            closeClient(client_fd);
+            break;
+    }
+}
+
+void EventLoop::onDBComplete(uint64_t key, bool success) {
+    HTTPConnection* conn = clients_.findByKey(key);
+    if (conn == nullptr) return;  // 等待期间连接已关闭
+    applyAction(ConnectionSlab::fdOf(key), *conn, conn->onDBComplete(success));
+}
+
+void EventLoop::updateEvents(int client_fd, HTTPConnection& conn, bool want_write) {
+    if (conn.want_write == want_write) return;
+    conn.want_write = want_write;
+    epoll_event event{};
+    event.data.u64 = clients_.key(client_fd);
+    event.events = EPOLLIN | EPOLLET | (want_write ? EPOLLOUT : 0);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client_fd, &event);
+}
+
+void EventLoop::closeClient(int client_fd) {
+    timer_->removeTimer(client_fd);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client_fd, nullptr);
+    clients_.close(client_fd);
+    close(client_fd);
+    conn_count_.fetch_sub(1, std::memory_order_relaxed);
+}
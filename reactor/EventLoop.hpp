@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+#include "../http/HTTPConnection.hpp"
+#include "../http/ConnectionSlab.hpp"
+#include "../sql/MySQLConnector.hpp"
+#include "../sql/DBExecutor.hpp"
+#include "../timer/timer.hpp"
+#include "../timer/cachedclock.hpp"
+#include "../metrics/metrics.hpp"
+
+// 子 reactor: 一个线程 + 一个 epoll 实例, 独占自己的连接表和定时器,
+// 连接从建立到关闭都只在该线程中处理, 请求路径上没有跨线程共享的锁
+class EventLoop {
+public:
+    EventLoop(int id, MySQLConnector* mysql, DBExecutor* db, TimerType timer_type);
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // 在 start 之前调用, 由本线程直接 accept 这个 (SO_REUSEPORT) 监听 socket
+    void setListenFd(int listen_fd) { listen_fd_ = listen_fd; }
+    void start(int cpu = -1);  // cpu >= 0 时把线程绑定到该 CPU
+    void stop();
+    void join();
+
+    // 由主 reactor 调用, 把新连接交给本线程, 线程安全
+    void addConnection(int client_fd);
+    // 在本线程中执行 task, 线程安全, 用于把数据库结果投递回连接所属的线程
+    void queueInLoop(std::function<void()> task);
+    // 当前负责的连接数, 用于 least-loaded 分配
+    size_t connectionCount() const { return conn_count_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int MAX_EVENTS_ = 1024;
+    static constexpr int MAX_TIMEOUT_ = 5000;  // 5 秒未活跃则关闭
+
+    void loop();
+    void wakeup();
+    void handleWakeup();
+    void acceptConnections();
+    void registerConnection(int client_fd);
+    void applyAction(int client_fd, HTTPConnection& conn, HTTPConnection::Action action);
+    void onDBComplete(uint64_t key, bool success);
+    void updateEvents(int client_fd, HTTPConnection& conn, bool want_write);
+    void closeClient(int client_fd);
+
+    int id_;
+    int epoll_fd_;
+    int wakeup_fd_;  // eventfd, 用于唤醒阻塞在 epoll_wait 中的线程
+    int listen_fd_;  // 自己负责 accept 的监听 socket, 没有时为 -1
+    MySQLConnector* mysql_;
+    DBExecutor* db_;
+    ConnectionSlab clients_;
+    std::unique_ptr<Timer> timer_;
+    CachedClock own_clock_;
+    CachedClock* clock_;  // 0 号事件循环同时负责刷新全局时钟, 其余使用 own_clock_
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<size_t> conn_count_;
+
+    std::mutex pending_mutex_;  // 只保护 pending_fds_ 和 pending_tasks_, 由其他线程和本线程共享
+    std::vector<int> pending_fds_;
+    std::vector<std::function<void()>> pending_tasks_;
+    std::vector<int> ready_fds_;  // 只由本线程访问, 正在处理的 pending_fds_ 和 pending_tasks_
+    std::vector<std::function<void()>> ready_tasks_;
+};
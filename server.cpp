@@ -6,7 +6,27 @@ constexpr int MAX_TIMEOUT = 5000;  // 5 秒未活跃则关闭
 constexpr int MAX_THREAD_COUNT = 10;  // 线程池最大容量
 
 // 构造函数中只是初始化端口号和一些成员变量，listen_fd_ 和 epoll_fd_ 暂时设为无效值。
-WebServer::WebServer(int port) : port_(port), listen_fd_(-1), epoll_fd_(-1), mysql(), thread_pool_(MAX_THREAD_COUNT) {}
+WebServer::WebServer(int port) : WebServer(ServerConfig{port}) {}
+
+WebServer::WebServer(const ServerConfig& config) : config_(config), port_(config.port), listen_fd_(-1), epoll_fd_(-1), mysql(config.sql), clients_(&mysql), timer_(createTimer(config.timer)), db_(config.sql.pool_size) {
+    if (config_.mode == ServerConfig::Mode::THREAD_POOL) {
+        thread_pool_ = std::make_unique<ThreadPool>(MAX_THREAD_COUNT);
+    }
+    registerGauges();
+}
+
+// /metrics 中导出时才读取的队列长度
+void WebServer::registerGauges() {
+    Metrics& metrics = Metrics::getInstance();
+    if (thread_pool_) {
+        metrics.addGauge("webserver_threadpool_pending_tasks", "Tasks waiting in the thread pool queues.",
+                         [this] { return static_cast<double>(thread_pool_->pendingTasks()); });
+    }
+    metrics.addGauge("webserver_db_pending_queries", "Queries waiting for a DB thread.",
+                     [this] { return static_cast<double>(db_.pending()); });
+    metrics.addGauge("webserver_log_queue_depth", "Log records not yet written to the file.",
+                     [] { return static_cast<double>(Logger::getInstance().queueDepth()); });
+}
 
 // 设置文件描述符非阻塞
 void WebServer::setNonBlocking(int fd) {
@@ -15,14 +35,14 @@ void WebServer::setNonBlocking(int fd) {
     fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 }
 
-void WebServer::initSocket() {
-    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);  // 创建 TCP socket
-    if (listen_fd_ == -1) {
+int WebServer::createListenSocket(bool reuse_port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);  // 创建 TCP socket
+    if (listen_fd == -1) {
         perror("socket creation failed");
         exit(EXIT_FAILURE);
     }
 
-    setNonBlocking(listen_fd_);  // 设置非阻塞
+    setNonBlocking(listen_fd);  // 设置非阻塞
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
@@ -30,19 +50,31 @@ void WebServer::initSocket() {
     addr.sin_addr.s_addr = INADDR_ANY;  // 监听所有 IP
 
     int opt = 1;
-    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuse_port) {
+        // 多个 socket 绑定同一端口, 由内核把新连接分散到各个 socket 的 accept 队列
+        if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+            perror("SO_REUSEPORT failed");
+            exit(EXIT_FAILURE);
+        }
+    }
 
     // 避免 bind 报地址被占用
-    if (bind(listen_fd_, (sockaddr*)&addr, sizeof(addr)) == -1) {
+    if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) == -1) {
         perror("bind failed");
         exit(EXIT_FAILURE);
     }
 
     // 开始监听连接
-    if (listen(listen_fd_, SOMAXCONN) == -1) {
+    if (listen(listen_fd, SOMAXCONN) == -1) {
         perror("listen failed");
         exit(EXIT_FAILURE);
     }
+    return listen_fd;
+}
+
+void WebServer::initSocket() {
+    listen_fd_ = createListenSocket(false);
 
     epoll_fd_ = epoll_create1(0);  // 创建 epoll 实例
     if (epoll_fd_ == -1) {
@@ -51,85 +83,200 @@ void WebServer::initSocket() {
     }
 
     epoll_event event{};
-    event.data.fd = listen_fd_;
+    event.data.u64 = ConnectionSlab::makeKey(listen_fd_, 0);
     event.events = EPOLLIN | EPOLLET;  // 可读 + 边缘触发
     epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
 }
 
 void WebServer::closeClient(int client_fd) {
-    heap_timer_.removeTimer(client_fd);
+    timer_->removeTimer(client_fd);
     epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client_fd, nullptr);
+    // 先在连接表中关闭再关闭 fd, 否则主线程可能在此之前 accept 到同一个 fd
+    clients_.close(client_fd);
     close(client_fd);
     // Logger::getInstance().log("INFO", "Client[" + std::to_string(client_fd) + "] is closed, which is used " + std::to_string(clients[client_fd].useCount) + " times.");
 }
 
-void WebServer::handleConnection(int client_fd) {
-    HTTPConnection* conn_ptr = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(clients_mutex_);
-        // HTTPConnection http_connection(client_fd);
-        // auto [iter, success] = clients.try_emplace(client_fd, std::move(http_connection));
-        auto [iter, success] = clients.try_emplace(client_fd, client_fd, &mysql);
-        conn_ptr = &(iter->second);
-        ++ conn_ptr->use_count;
-    }
+void WebServer::handleEvents(uint64_t key, uint32_t events, int64_t dispatched_ns) {
+    // 连接状态由持有 EPOLLONESHOT 事件的工作线程独占
+    HTTPConnection* conn_ptr = clients_.findByKey(key);
+    if (conn_ptr == nullptr) return;
     HTTPConnection& conn = *conn_ptr;
+    int client_fd = ConnectionSlab::fdOf(key);
+    conn.setDispatchTime(dispatched_ns);
+    // 可读事件中也会继续发送未发完的数据
+    HTTPConnection::Action action = (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) ? conn.onReadable() : conn.onWritable();
+    applyAction(client_fd, conn, action);
+}
 
-    // 接收请求数据
-    std::string raw_data;
-    bool isConnection = conn.receiveRequest(raw_data);
-    if (!isConnection) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            {
-                std::lock_guard<std::mutex> lock(clients_mutex_);
-                Logger::getInstance().log("ERROR", "Client[" + std::to_string(client_fd) + "] is closed due to network error or read error, and it is used " + std::to_string(conn.use_count) + " times.");
+void WebServer::applyAction(int client_fd, HTTPConnection& conn, HTTPConnection::Action action) {
+    switch (action) {
+        case HTTPConnection::Action::WAIT_READ:
+        case HTTPConnection::Action::WAIT_WRITE: {
+            timer_->updateTimer(client_fd, MAX_TIMEOUT);
+            // 重新注册事件之后, 下一个事件可能马上被分发给其他工作线程, 因此对连接的所有写入都要在 rearm 之前完成.
+            // in_flight 归零后定时器才能关闭连接, 而超时时间刚刚被刷新, 在 rearm 之前不会到期
+            bool want_write = action == HTTPConnection::Action::WAIT_WRITE;
+            uint64_t key = clients_.key(client_fd);
+            conn.want_write = want_write;
+            conn.in_flight.fetch_sub(1);
+            rearm(client_fd, key, want_write);
+            break;
+        }
+        case HTTPConnection::Action::WAIT_DB:
+            // 不重新注册事件, in_flight 保持不变, 等待期间连接不会被其他工作线程处理, 也不会被定时器关闭.
+            // 结果由数据库线程投递回线程池, 在 onDBComplete 中继续处理
+            if (auto query = conn.takeDBQuery()) {
+                uint64_t key = clients_.key(client_fd);
+                db_.submit(std::move(query), [this, key](bool success) {
+                    thread_pool_->submit([this, key, success] { onDBComplete(key, success); });
+                });
+            } else {
+                // 没有可提交的查询就不会有 onDBComplete, 连接既不会被重新注册也不会超时, 只能关闭
+                LOG_ERROR("Client[{}] is waiting for a database result without a query, close it.", client_fd);
+                Metrics::add(Counter::CLOSED_BY_ERROR);
                 closeClient(client_fd);
-                clients.erase(client_fd);
             }
-        }
-        return;
-    }
-
-    // 处理请求
-    conn.parseRequest(raw_data);
-    conn.sendResponse();
-
-    // 根据连接状态处理
-    {
-        std::lock_guard<std::mutex> lock(clients_mutex_);
-        if (conn.is_keep_alive) {
-            heap_timer_.updateTimer(client_fd, MAX_TIMEOUT);
-        } else {
-            Logger::getInstance().log("INFO", "Client[" + std::to_string(client_fd) + "] is closed due to http request, and it is used " + std::to_string(conn.use_count) + " times.");
+            break;
+        case HTTPConnection::Action::CLOSE:
+            LOG_INFO("Client[{}] is closed due to http request, and it is used {} times.", client_fd, conn.use_count);
+            Metrics::add(Counter::CLOSED_BY_REQUEST);
             closeClient(client_fd);
-            clients.erase(client_fd);
-        }
+            break;
+        case HTTPConnection::Action::ERROR:
+            LOG_ERROR("Client[{}] is closed due to network error or read error, and it is used {} times.", client_fd, conn.use_count);
+            Metrics::add(Counter::CLOSED_BY_ERROR);
+            closeClient(client_fd);
+            break;
     }
 }
 
+void WebServer::onDBComplete(uint64_t key, bool success) {
+    HTTPConnection* conn = clients_.findByKey(key);
+    if (conn == nullptr) return;  // 等待期间连接已关闭
+    applyAction(ConnectionSlab::fdOf(key), *conn, conn->onDBComplete(success));
+}
+
+void WebServer::rearm(int client_fd, uint64_t key, bool want_write) {
+    // 发送缓冲区已满时关注 EPOLLOUT, 等 socket 可写时继续发送
+    epoll_event event{};
+    event.data.u64 = key;
+    event.events = EPOLLIN | EPOLLET | EPOLLONESHOT | (want_write ? EPOLLOUT : 0);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client_fd, &event);
+}
+
 void WebServer::run() {
+    if (config_.mode == ServerConfig::Mode::MULTI_REACTOR && config_.reuse_port) {
+        runReusePort();  // 每个子 reactor 有自己的监听 socket, 不需要主 reactor
+        return;
+    }
+
     initSocket();  // 初始化服务器 socket + epoll
     std::cout << "Listening on port " << port_ << "...\n";
-    Logger::getInstance().log("INFO", "Listening on port " + std::to_string(port_) + "...");
+    LOG_INFO("Listening on port {}...", port_);
+
+    if (config_.mode == ServerConfig::Mode::MULTI_REACTOR) {
+        runMultiReactor();
+    } else {
+        runThreadPool();
+    }
 
+    close(listen_fd_);
+    close(epoll_fd_);
+}
+
+void WebServer::createLoops() {
+    unsigned int cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    size_t loop_count = config_.loop_count > 0 ? config_.loop_count : cpu_count;
+    for (size_t i = 0; i < loop_count; ++ i) {
+        loops_.emplace_back(std::make_unique<EventLoop>(static_cast<int>(i), &mysql, &db_, config_.timer));
+        if (config_.reuse_port) {
+            loops_.back()->setListenFd(createListenSocket(true));
+        }
+        loops_.back()->start(config_.pin_cpu ? static_cast<int>(i % cpu_count) : -1);
+    }
+    LOG_INFO("Multi-reactor mode with {} event loops{}{}", loop_count,
+             config_.reuse_port ? ", SO_REUSEPORT listeners" : "", config_.pin_cpu ? ", pinned to CPUs" : "");
+}
+
+void WebServer::runReusePort() {
+    createLoops();
+    std::cout << "Listening on port " << port_ << " with " << loops_.size() << " SO_REUSEPORT sockets...\n";
+    LOG_INFO("Listening on port {}...", port_);
+
+    // accept 全部在子 reactor 中完成, 主线程只需等待
+    for (auto& loop: loops_) loop->join();
+}
+
+EventLoop* WebServer::selectLoop() {
+    if (config_.dispatch == ServerConfig::Dispatch::LEAST_LOADED) {
+        EventLoop* best = loops_[0].get();
+        for (auto& loop: loops_) {
+            if (loop->connectionCount() < best->connectionCount()) best = loop.get();
+        }
+        return best;
+    }
+    EventLoop* loop = loops_[next_loop_].get();
+    next_loop_ = (next_loop_ + 1) % loops_.size();
+    return loop;
+}
+
+void WebServer::runMultiReactor() {
+    createLoops();
+
+    epoll_event events[MAX_EVENTS];
+
+    // 主 reactor 只负责 accept, 连接建立后交给子 reactor, 之后该连接的所有事件都在同一个线程中处理
+    while (true) {
+        int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+        if (nfds == -1) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            break;
+        }
+
+        for (int i = 0; i < nfds; ++ i) {
+            if (events[i].data.fd != listen_fd_) continue;
+            while (true) {
+                sockaddr_in client_addr{};
+                socklen_t client_len = sizeof(client_addr);
+                int client_fd = accept(listen_fd_, (sockaddr*)&client_addr, &client_len);
+                if (client_fd < 0) break;
+
+                setNonBlocking(client_fd);  // 设置为非阻塞模式
+                selectLoop()->addConnection(client_fd);
+            }
+        }
+    }
+
+    for (auto& loop: loops_) loop->stop();
+}
+
+void WebServer::runThreadPool() {
     epoll_event events[MAX_EVENTS];  // 每个 events[i] 都表示一个就绪的 socket 文件描述符（fd）及其事件类型
+    std::vector<Task> tasks;  // 一次 epoll_wait 产生的任务, 批量提交给线程池
+    tasks.reserve(MAX_EVENTS);
+    std::vector<int> expired_fds;
+    const bool tracing = Tracer::getInstance().enabled();
 
     // 持续监听
     while (true) {
-        int timeout = heap_timer_.getNextTick();  // 每次循环动态调整等待时间
+        int timeout = timer_->getNextTick();  // 每次循环动态调整等待时间
 
         // 获取请求队列长度
         // int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);  // 阻塞等待就绪事件
         int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout);  // 阻塞等待就绪事件
+        CachedClock::global().update();  // 工作线程没有自己的时钟, 本轮的事件处理、定时器和日志都使用全局时钟
         if (nfds == -1) {
             perror("epoll_wait failed");
             break;
         }
+        int64_t dispatched_ns = tracing ? Tracer::now() : 0;  // 本轮分发的任务从这里开始排队
         
         // 遍历请求队列中的每一个 Connection
         for (int i = 0; i < nfds; ++ i) {
-            int fd = events[i].data.fd;
-            if (fd == listen_fd_) {
+            uint64_t key = events[i].data.u64;
+            if (ConnectionSlab::fdOf(key) == listen_fd_) {
                 // 接收新连接, 持续接收, 直至没有新的连接到达
                 while (true) {
                     sockaddr_in client_addr{};
@@ -138,34 +285,48 @@ void WebServer::run() {
                     if (client_fd < 0) break;
 
                     setNonBlocking(client_fd);  // 设置为非阻塞模式
-                    heap_timer_.addTimer(client_fd, MAX_TIMEOUT);  // 给client_fd添加定时器
-                    Logger::getInstance().log("INFO", "Client[" + std::to_string(client_fd) + "] in!");
+                    if (clients_.open(client_fd) == nullptr) {
+                        LOG_ERROR("Client[{}] exceeds the connection table, closed", client_fd);
+                        close(client_fd);
+                        continue;
+                    }
+                    timer_->addTimer(client_fd, MAX_TIMEOUT);  // 给client_fd添加定时器
+                    Metrics::add(Counter::ACCEPTS);
+                    LOG_INFO("Client[{}] in!", client_fd);
 
+                    // EPOLLONESHOT: 事件触发一次后自动停止监听, 处理完成后由工作线程重新注册,
+                    // 保证同一时间只有一个工作线程在处理这个连接
                     epoll_event event{};
-                    event.data.fd = client_fd;
-                    event.events = EPOLLIN | EPOLLET;
+                    event.data.u64 = clients_.key(client_fd);
+                    event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
                     epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &event);
                 }
             } else {
-                // 处理客户端数据
-                thread_pool_.enqueue([this, fd] {
-                    this->handleConnection(fd);
+                // 主线程在分发时计数, 工作线程重新注册事件之后减一, 计数不为 0 时定时器不会关闭该连接
+                uint32_t ready = events[i].events;
+                HTTPConnection* conn = clients_.findByKey(key);
+                if (conn == nullptr) continue;  // 连接已关闭, 或者是 fd 被复用之前残留的事件
+                conn->in_flight.fetch_add(1);
+                tasks.emplace_back([this, key, ready, dispatched_ns] {
+                    this->handleEvents(key, ready, dispatched_ns);
                 });
             }
         }
-        std::vector<int> expired_fds;
-        heap_timer_.tick(expired_fds);
+        if (!tasks.empty()) thread_pool_->submitBatch(tasks);
+
+        expired_fds.clear();
+        timer_->tick(expired_fds);
+        if (!expired_fds.empty()) Metrics::add(Counter::TIMER_EXPIRATIONS, expired_fds.size());
 
         for (int fd: expired_fds) {
-            auto it = clients.find(fd);
-            if (it != clients.end()) {
-                Logger::getInstance().log("INFO", "Client[" + std::to_string(fd) + "] is closed due to timeout, and it is used " + std::to_string(it->second.use_count) + " times.");
-                closeClient(fd);
-                clients.erase(fd);
-            }
+            HTTPConnection* conn = clients_.find(fd);
+            if (conn == nullptr) continue;
+            // 连接正在被工作线程处理时不关闭, 工作线程处理完成后会刷新定时器
+            int idle = 0;
+            if (!conn->in_flight.compare_exchange_strong(idle, -1)) continue;
+            LOG_INFO("Client[{}] is closed due to timeout, and it is used {} times.", fd, conn->use_count);
+            Metrics::add(Counter::CLOSED_BY_TIMEOUT);
+            closeClient(fd);
         }
     }
-
-    close(listen_fd_);
-    close(epoll_fd_);
 }
\ No newline at end of file
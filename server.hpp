@@ -4,6 +4,8 @@
 #include <sstream>
 #include <unordered_map>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include <cstring>
 #include <unistd.h>
 #include <fcntl.h>
@@ -11,28 +13,66 @@
 #include <sys/epoll.h>
 #include "http/http_request.hpp"
 #include "http/HTTPConnection.hpp"
+#include "http/ConnectionSlab.hpp"
 #include "sql/MySQLConnector.hpp"
+#include "sql/DBExecutor.hpp"
 #include "log/log.hpp"
-#include "timer/heaptimer.hpp"
+#include "metrics/metrics.hpp"
+#include "timer/timer.hpp"
 #include "pool/ThreadPool.hpp"
+#include "reactor/EventLoop.hpp"
+
+struct ServerConfig {
+    enum class Mode {
+        THREAD_POOL,  // 单个 epoll 线程 + 工作线程池
+        MULTI_REACTOR  // 主 reactor 只负责 accept, 每个子 reactor 拥有独立的 epoll、连接表和定时器
+    };
+    enum class Dispatch {
+        ROUND_ROBIN,  // 轮流分配
+        LEAST_LOADED  // 分配给当前连接数最少的子 reactor
+    };
+
+    int port = 8080;
+    Mode mode = Mode::THREAD_POOL;
+    int loop_count = 0;  // 子 reactor 数量, 0 表示使用 CPU 核数
+    Dispatch dispatch = Dispatch::ROUND_ROBIN;
+    bool reuse_port = false;  // 每个子 reactor 一个 SO_REUSEPORT 监听 socket, 各自 accept
+    bool pin_cpu = false;  // 把第 i 个子 reactor 线程绑定到第 i 个 CPU
+    TimerType timer = TimerType::HEAP;  // 连接超时定时器的实现
+    SqlConfig sql;  // 数据库地址和连接池大小
+};
 
 class WebServer {
 public:
     explicit WebServer(int port);
+    explicit WebServer(const ServerConfig& config);
     void run();
     void closeClient(int fd);
 
 private:
+    ServerConfig config_;
     int port_;  // 端口号
     int listen_fd_;  // 
     int epoll_fd_;  // 
     MySQLConnector mysql;
-    std::unordered_map<int, HTTPConnection> clients;
-    HeapTimer heap_timer_;
-    ThreadPool thread_pool_;
-    std::mutex clients_mutex_;
+    ConnectionSlab clients_;  // 线程池模式下的连接表
+    std::unique_ptr<Timer> timer_;
+    std::unique_ptr<ThreadPool> thread_pool_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;  // MULTI_REACTOR 模式下的子 reactor
+    size_t next_loop_ = 0;
+    DBExecutor db_;  // 最后构造、最先析构, 停止之后不会再向线程池或子 reactor 投递结果
 
+    int createListenSocket(bool reuse_port);
     void initSocket();
-    void handleConnection(int client_fd);
+    void createLoops();
+    void registerGauges();
+    void runThreadPool();
+    void runMultiReactor();
+    void runReusePort();
+    EventLoop* selectLoop();
+    void handleEvents(uint64_t key, uint32_t events, int64_t dispatched_ns);  // dispatched_ns 为 0 表示不追踪
+    void applyAction(int client_fd, HTTPConnection& conn, HTTPConnection::Action action);
+    void onDBComplete(uint64_t key, bool success);
+    void rearm(int client_fd, uint64_t key, bool want_write);
     void setNonBlocking(int fd);
-};
\ No newline at end of file
+};
@@ -0,0 +1,58 @@
+#include "DBExecutor.hpp"
+
+#include "../log/log.hpp"
+
+DBExecutor::DBExecutor(size_t thread_count) {
+    if (thread_count == 0) thread_count = 1;
+    for (size_t i = 0; i < thread_count; ++ i) {
+        threads_.emplace_back(&DBExecutor::worker, this);
+    }
+}
+
+DBExecutor::~DBExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        jobs_.clear();
+    }
+    cond_.notify_all();
+    for (std::thread& t: threads_) t.join();
+}
+
+void DBExecutor::submit(Query query, Done done) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stop_ && jobs_.size() < MAX_PENDING_) {
+            jobs_.push_back({std::move(query), std::move(done)});
+            cond_.notify_one();
+            return;
+        }
+    }
+    LOG_WARNING("DB queue is full, request rejected");
+    done(false);
+}
+
+size_t DBExecutor::pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+void DBExecutor::worker() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        bool result = false;
+        try {
+            result = job.query();
+        } catch (std::exception& e) {
+            LOG_ERROR("DB query failed: {}", e.what());
+        }
+        job.done(result);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// 专门执行数据库请求的线程组. 事件循环和工作线程只负责提交, 查询在这里同步执行,
+// 完成后调用 done, 由 done 把结果投递回连接所属的事件循环 (或线程池), 数据库再慢也不会阻塞静态文件请求
+class DBExecutor {
+public:
+    using Query = std::function<bool()>;
+    using Done = std::function<void(bool)>;
+
+    explicit DBExecutor(size_t thread_count);
+    ~DBExecutor();  // 未执行的请求直接丢弃, 不再调用 done
+    DBExecutor(const DBExecutor&) = delete;
+    DBExecutor& operator=(const DBExecutor&) = delete;
+
+    // 线程安全, 不会阻塞. 排队的请求过多时不执行查询, 直接以 false 调用 done
+    void submit(Query query, Done done);
+    size_t pending();
+
+private:
+    static constexpr size_t MAX_PENDING_ = 10000;
+
+    struct Job {
+        Query query;
+        Done done;
+    };
+
+    void worker();
+
+    std::vector<std::thread> threads_;
+    std::deque<Job> jobs_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_ = false;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <memory>
 #include <cppconn/driver.h>
 #include <cppconn/connection.h>
 #include <cppconn/exception.h>
@@ -8,16 +9,18 @@
 #include <cppconn/resultset.h>
 #include <iostream>
 #include <../log/log.hpp>
+#include "SqlConnPool.hpp"
 
+// 用户表的访问接口, 每次调用从连接池借一个连接并复用其上缓存的预处理语句, 可以被多个线程同时调用
 class MySQLConnector {
 public:
     MySQLConnector();
+    explicit MySQLConnector(const SqlConfig& config);
     MySQLConnector(const std::string&, const std::string&, const std::string&, const std::string&, unsigned int);
-    ~MySQLConnector();
+    ~MySQLConnector() = default;
 
     bool insertUser(const std::string&, const std::string&);
     bool verifyUser(const std::string&, const std::string&);
 private:
-    sql::Driver* driver_;  // 保存 driver 实例
-    sql::Connection* conn_;  // 使用 Connector//C++ 的 Connection 对象
-};
\ No newline at end of file
+    SqlConnPool pool_;
+};
@@ -0,0 +1,163 @@
+#include "SqlConnPool.hpp"
+
+#include <chrono>
+#include "../log/log.hpp"
+#include "../timer/cachedclock.hpp"
+
+PooledConnection::~PooledConnection() {
+    statements_.clear();  // 语句先于连接释放
+    delete conn_;
+}
+
+sql::PreparedStatement* PooledConnection::prepare(const std::string& query) {
+    for (auto& [text, stmt] : statements_) {
+        if (text == query) {
+            stmt->clearParameters();
+            return stmt.get();
+        }
+    }
+    std::unique_ptr<sql::PreparedStatement> stmt(conn_->prepareStatement(query));
+    if (statements_.size() >= MAX_STATEMENTS_) statements_.erase(statements_.begin());
+    statements_.emplace_back(query, std::move(stmt));
+    return statements_.back().second.get();
+}
+
+void PooledConnection::clearStatements() {
+    statements_.clear();
+}
+
+SqlConnPool::Handle& SqlConnPool::Handle::operator=(Handle&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        conn_ = other.conn_;
+        broken_ = other.broken_;
+        other.pool_ = nullptr;
+        other.conn_ = nullptr;
+    }
+    return *this;
+}
+
+void SqlConnPool::Handle::release() {
+    if (pool_ && conn_) pool_->giveBack(conn_, broken_);
+    pool_ = nullptr;
+    conn_ = nullptr;
+    broken_ = false;
+}
+
+SqlConnPool::SqlConnPool(const SqlConfig& config) : config_(config), driver_(nullptr) {
+    if (config_.pool_size == 0) config_.pool_size = 1;
+    try {
+        driver_ = get_driver_instance();
+    } catch (sql::SQLException& e) {
+        LOG_ERROR("MySQL driver unavailable: {}", e.what());
+        return;
+    }
+
+    // 启动时建立全部连接, 失败的部分在 acquire() 时再补
+    int64_t now = CachedClock::getInstance().nowMs();
+    idle_.reserve(config_.pool_size);
+    for (size_t i = 0; i < config_.pool_size; ++ i) {
+        PooledConnection* conn = connect();
+        if (!conn) break;
+        idle_.push_back({conn, now});
+    }
+    open_ = idle_.size();
+    LOG_INFO("MySQL pool: {}/{} connections established", open_, config_.pool_size);
+}
+
+SqlConnPool::~SqlConnPool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    for (Idle& idle : idle_) delete idle.conn;
+    idle_.clear();
+    // 仍被借出的连接由 Handle 归还时释放
+}
+
+PooledConnection* SqlConnPool::connect() {
+    if (!driver_) return nullptr;
+    try {
+        std::unique_ptr<sql::Connection> conn(driver_->connect(config_.host, config_.user, config_.password));
+        conn->setSchema(config_.dbname);
+        return new PooledConnection(conn.release());
+    } catch (sql::SQLException& e) {
+        LOG_ERROR("MySQL connect failed: {} (code {})", e.what(), e.getErrorCode());
+        return nullptr;
+    }
+}
+
+// conn 失效时先尝试 reconnect(), 仍然失败则重新建立. 返回 false 时 conn 已被释放
+bool SqlConnPool::checkHealth(PooledConnection*& conn) {
+    try {
+        sql::Connection* raw = conn->connection();
+        if (raw->isValid()) return true;
+        conn->clearStatements();
+        if (raw->reconnect() && raw->isValid()) {
+            raw->setSchema(config_.dbname);
+            LOG_WARNING("MySQL connection reconnected");
+            return true;
+        }
+    } catch (sql::SQLException& e) {
+        LOG_WARNING("MySQL health check failed: {}", e.what());
+    }
+    delete conn;
+    conn = connect();
+    return conn != nullptr;
+}
+
+SqlConnPool::Handle SqlConnPool::acquire() {
+    return acquire(config_.wait_timeout_ms);
+}
+
+SqlConnPool::Handle SqlConnPool::acquire(int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!closed_ && idle_.empty() && open_ >= config_.pool_size) {
+        if (cond_.wait_until(lock, deadline) == std::cv_status::timeout && idle_.empty() && open_ >= config_.pool_size) {
+            LOG_WARNING("MySQL pool: no connection available after {} ms", timeout_ms);
+            return Handle();
+        }
+    }
+    if (closed_) return Handle();
+
+    PooledConnection* conn = nullptr;
+    bool check = false;
+    if (!idle_.empty()) {
+        Idle idle = idle_.back();
+        idle_.pop_back();
+        conn = idle.conn;
+        check = CachedClock::getInstance().nowMs() - idle.last_used_ms >= HEALTH_CHECK_IDLE_MS_;
+    } else {
+        ++ open_;  // 先占住名额, 在锁外建立连接
+    }
+    lock.unlock();
+
+    bool ok = conn ? (!check || checkHealth(conn)) : (conn = connect()) != nullptr;
+    if (!ok) {
+        lock.lock();
+        -- open_;
+        lock.unlock();
+        cond_.notify_one();
+        return Handle();
+    }
+    return Handle(this, conn);
+}
+
+void SqlConnPool::giveBack(PooledConnection* conn, bool broken) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (broken || closed_) {
+            // 丢弃连接, 空出的名额由下一次 acquire() 重新建立
+            -- open_;
+            delete conn;
+        } else {
+            idle_.push_back({conn, CachedClock::getInstance().nowMs()});
+        }
+    }
+    cond_.notify_one();
+}
+
+size_t SqlConnPool::idleCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cppconn/driver.h>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+
+struct SqlConfig {
+    std::string host = "tcp://127.0.0.1:3306";
+    std::string user = "root";
+    std::string password = "Lx@259416";
+    std::string dbname = "WebServer_DB";
+    size_t pool_size = 8;  // 连接数上限, 启动时全部建立
+    int wait_timeout_ms = 500;  // 没有空闲连接时最多等待的时间
+};
+
+// 池中的一个连接和在它上面准备好的语句. 语句在连接的整个生命周期内复用,
+// 之后每次执行只需要一次往返, 不再先 prepare 再 close
+class PooledConnection {
+public:
+    explicit PooledConnection(sql::Connection* conn) : conn_(conn) {}
+    ~PooledConnection();
+    PooledConnection(const PooledConnection&) = delete;
+    PooledConnection& operator=(const PooledConnection&) = delete;
+
+    sql::Connection* connection() const { return conn_; }
+    // 返回缓存的语句, 第一次使用时在服务器上准备, 参数已被清空. 语句归连接所有, 调用者不能 delete
+    sql::PreparedStatement* prepare(const std::string& query);
+    void clearStatements();  // 重连之后服务器上的语句已经不存在
+
+private:
+    static constexpr size_t MAX_STATEMENTS_ = 8;  // 超过时淘汰最早准备的语句
+
+    sql::Connection* conn_;
+    std::vector<std::pair<std::string, std::unique_ptr<sql::PreparedStatement>>> statements_;
+};
+
+// 有界的 MySQL 连接池. 连接在启动时建立, 通过 acquire() 借出, Handle 析构时自动归还.
+// 借出时对空闲过久的连接做 isValid() 检查, 失效的连接先 reconnect(), 不行再重新建立;
+// 使用中出错的连接 (Handle::markBroken) 归还时被丢弃, 下次借出时补上
+class SqlConnPool {
+public:
+    class Handle {
+    public:
+        Handle() = default;
+        Handle(Handle&& other) noexcept : pool_(other.pool_), conn_(other.conn_), broken_(other.broken_) { other.pool_ = nullptr; other.conn_ = nullptr; }
+        Handle& operator=(Handle&& other) noexcept;
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        ~Handle() { release(); }
+
+        explicit operator bool() const { return conn_ != nullptr; }
+        PooledConnection* operator->() const { return conn_; }
+        PooledConnection* get() const { return conn_; }
+        // 执行语句时抛出了 SQLException, 连接状态未知, 归还时不再复用
+        void markBroken() { broken_ = true; }
+        void release();
+
+    private:
+        friend class SqlConnPool;
+        Handle(SqlConnPool* pool, PooledConnection* conn) : pool_(pool), conn_(conn) {}
+
+        SqlConnPool* pool_ = nullptr;
+        PooledConnection* conn_ = nullptr;
+        bool broken_ = false;
+    };
+
+    SqlConnPool(const SqlConfig& config);
+    ~SqlConnPool();
+    SqlConnPool(const SqlConnPool&) = delete;
+    SqlConnPool& operator=(const SqlConnPool&) = delete;
+
+    // 等待最多 wait_timeout_ms, 超时或无法建立连接时返回空的 Handle
+    Handle acquire();
+    Handle acquire(int timeout_ms);
+
+    size_t size() const { return config_.pool_size; }
+    size_t idleCount();
+
+private:
+    struct Idle {
+        PooledConnection* conn;
+        int64_t last_used_ms;  // 上次归还的时间, 用来决定是否需要检查连接
+    };
+
+    static constexpr int64_t HEALTH_CHECK_IDLE_MS_ = 30 * 1000;  // 空闲超过该时间的连接借出前先检查
+
+    PooledConnection* connect();
+    bool checkHealth(PooledConnection*& conn);
+    void giveBack(PooledConnection* conn, bool broken);
+
+    SqlConfig config_;
+    sql::Driver* driver_;  // 单例, 不需要释放
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<Idle> idle_;  // 空闲连接, 后进先出, 热的连接优先被复用
+    size_t open_ = 0;  // 已建立 (空闲 + 借出) 的连接数, 不超过 pool_size
+    bool closed_ = false;
+};
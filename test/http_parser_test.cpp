@@ -0,0 +1,154 @@
+// HttpParser 的单元测试: 分段到达、pipelining、超长 header 和 Content-Length 的边界情况
+#include <gtest/gtest.h>
+
+#include <string>
+#include "../http/http_request.hpp"
+
+using Result = HttpParser::Result;
+
+static const std::string GET = "GET /index.html?a=1 HTTP/1.1\r\nHost: 127.0.0.1\r\nAccept: */*\r\n\r\n";
+static const std::string POST = "POST /login HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 21\r\n\r\nusername=a&password=b";
+
+TEST(HttpParser, ParsesSimpleGet) {
+    std::string buffer = GET;
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(buffer.data(), buffer.size()), Result::COMPLETE);
+    const HttpRequestView& request = parser.request();
+    EXPECT_EQ(request.method, "GET");
+    EXPECT_EQ(request.path, "/index.html");
+    EXPECT_EQ(request.query, "a=1");
+    EXPECT_EQ(request.version, "HTTP/1.1");
+    EXPECT_EQ(request.header("host"), "127.0.0.1");
+    EXPECT_TRUE(request.keep_alive);
+    EXPECT_TRUE(request.body.empty());
+    EXPECT_EQ(parser.consumed(), buffer.size());
+}
+
+TEST(HttpParser, KeepAliveDefaults) {
+    std::string http10 = "GET / HTTP/1.0\r\n\r\n";
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(http10.data(), http10.size()), Result::COMPLETE);
+    EXPECT_FALSE(parser.request().keep_alive);
+
+    std::string close = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n";
+    parser.reset();
+    ASSERT_EQ(parser.parse(close.data(), close.size()), Result::COMPLETE);
+    EXPECT_FALSE(parser.request().keep_alive);
+}
+
+// 每次只多到达一个字节, 缓冲区像连接中一样增长 (可能重新分配)
+TEST(HttpParser, HandlesRequestSplitAtEveryByte) {
+    for (const std::string& raw: {GET, POST}) {
+        std::string buffer;
+        HttpParser parser;
+        for (size_t i = 0; i < raw.size(); ++ i) {
+            buffer.push_back(raw[i]);
+            Result result = parser.parse(buffer.data(), buffer.size());
+            if (i + 1 < raw.size()) {
+                ASSERT_EQ(result, Result::NEED_MORE) << "at byte " << i;
+            } else {
+                ASSERT_EQ(result, Result::COMPLETE);
+            }
+        }
+        EXPECT_EQ(parser.consumed(), raw.size());
+        if (raw == POST) {
+            EXPECT_EQ(parser.request().body, "username=a&password=b");
+        }
+    }
+}
+
+TEST(HttpParser, ParsesPipelinedRequests) {
+    std::string buffer = GET + POST + GET;
+    HttpParser parser;
+    size_t pos = 0;
+    const char* methods[] = {"GET", "POST", "GET"};
+    for (const char* method: methods) {
+        ASSERT_EQ(parser.parse(buffer.data() + pos, buffer.size() - pos), Result::COMPLETE);
+        EXPECT_EQ(parser.request().method, method);
+        pos += parser.consumed();
+        parser.reset();
+    }
+    EXPECT_EQ(pos, buffer.size());
+    EXPECT_EQ(parser.parse(buffer.data() + pos, buffer.size() - pos), Result::NEED_MORE);
+}
+
+// 第二个请求只到达了一部分
+TEST(HttpParser, StopsAtPartialPipelinedRequest) {
+    std::string buffer = GET + POST.substr(0, 30);
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(buffer.data(), buffer.size()), Result::COMPLETE);
+    size_t pos = parser.consumed();
+    EXPECT_EQ(pos, GET.size());
+    parser.reset();
+    EXPECT_EQ(parser.parse(buffer.data() + pos, buffer.size() - pos), Result::NEED_MORE);
+    buffer += POST.substr(30);
+    ASSERT_EQ(parser.parse(buffer.data() + pos, buffer.size() - pos), Result::COMPLETE);
+    EXPECT_EQ(parser.request().body, "username=a&password=b");
+}
+
+TEST(HttpParser, DecodesChunkedBody) {
+    std::string buffer = "POST /register HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                         "5\r\nhello\r\n7;ext=1\r\n, world\r\n0\r\nX-Trailer: 1\r\n\r\nGET / HTTP/1.1\r\n\r\n";
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(buffer.data(), buffer.size()), Result::COMPLETE);
+    EXPECT_EQ(parser.request().body, "hello, world");
+    size_t pos = parser.consumed();
+    parser.reset();
+    ASSERT_EQ(parser.parse(buffer.data() + pos, buffer.size() - pos), Result::COMPLETE);
+    EXPECT_EQ(parser.request().path, "/");
+}
+
+TEST(HttpParser, RejectsOversizeHeaders) {
+    // 没有结尾的空行, 超过上限时不再等待更多数据
+    std::string buffer = "GET / HTTP/1.1\r\nX-Long: " + std::string(HttpParser::MAX_HEADER_BYTES, 'a');
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(buffer.data(), buffer.size()), Result::ERROR);
+
+    // 完整但超过上限
+    buffer += "\r\n\r\n";
+    parser.reset();
+    EXPECT_EQ(parser.parse(buffer.data(), buffer.size()), Result::ERROR);
+}
+
+TEST(HttpParser, RejectsTooManyHeaders) {
+    std::string buffer = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i <= HttpRequestView::MAX_HEADERS; ++ i) buffer += "X-H" + std::to_string(i) + ": v\r\n";
+    buffer += "\r\n";
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(buffer.data(), buffer.size()), Result::ERROR);
+}
+
+TEST(HttpParser, RejectsConflictingContentLength) {
+    std::string buffer = "POST /login HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 21\r\n\r\nusername=a&password=b";
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(buffer.data(), buffer.size()), Result::ERROR);
+}
+
+TEST(HttpParser, AcceptsRepeatedIdenticalContentLength) {
+    std::string buffer = "POST /login HTTP/1.1\r\nContent-Length: 3\r\ncontent-length: 3\r\n\r\nabc";
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(buffer.data(), buffer.size()), Result::COMPLETE);
+    EXPECT_EQ(parser.request().body, "abc");
+}
+
+TEST(HttpParser, RejectsContentLengthWithChunked) {
+    std::string buffer = "POST /login HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n";
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(buffer.data(), buffer.size()), Result::ERROR);
+}
+
+TEST(HttpParser, RejectsMalformedContentLength) {
+    for (const char* value: {"", "12a", "-1", "99999999999999999999"}) {
+        std::string buffer = std::string("POST / HTTP/1.1\r\nContent-Length: ") + value + "\r\n\r\n";
+        HttpParser parser;
+        EXPECT_EQ(parser.parse(buffer.data(), buffer.size()), Result::ERROR) << "Content-Length: " << value;
+    }
+}
+
+TEST(HttpParser, RejectsMalformedRequestLine) {
+    for (const char* line: {"GET\r\n\r\n", "GET /\r\n\r\n", " / HTTP/1.1\r\n\r\n", "GET  HTTP/1.1\r\n\r\n"}) {
+        std::string buffer = line;
+        HttpParser parser;
+        EXPECT_EQ(parser.parse(buffer.data(), buffer.size()), Result::ERROR) << line;
+    }
+}
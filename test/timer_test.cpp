@@ -0,0 +1,189 @@
+// 定时器的随机化测试: 随机地添加、刷新、删除定时器并推进时间, 每次 tick 的结果都与参考模型对比
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+#include "../timer/heaptimer.hpp"
+#include "../timer/timingwheel.hpp"
+
+// 用可控的假时钟代替 cachedclock.cpp, update() 把缓存的时间设置为 fake_now_ms
+static int64_t fake_now_ms = 1'000'000;
+
+CachedClock& CachedClock::getInstance() {
+    static CachedClock instance;
+    return instance;
+}
+
+CachedClock::CachedClock() : now_ms_(fake_now_ms), wall_time_ms_(0) {}
+
+void CachedClock::update() {
+    now_ms_.store(fake_now_ms, std::memory_order_relaxed);
+}
+
+static void advance(int64_t ms) {
+    fake_now_ms += ms;
+    CachedClock::getInstance().update();
+}
+
+// 参考模型: fd -> 过期时间, 过期时间不晚于当前时间的定时器在 tick 时全部取出
+class ReferenceTimer {
+public:
+    void add(int fd, int timeout_ms) { expires_[fd] = fake_now_ms + timeout_ms; }
+    void remove(int fd) { expires_.erase(fd); }
+
+    std::vector<int> tick() {
+        std::vector<int> expired;
+        for (auto it = expires_.begin(); it != expires_.end();) {
+            if (it->second <= fake_now_ms) {
+                expired.push_back(it->first);
+                it = expires_.erase(it);
+            } else {
+                ++ it;
+            }
+        }
+        return expired;
+    }
+
+    bool empty() const { return expires_.empty(); }
+
+    int64_t earliest() const {
+        int64_t result = INT64_MAX;
+        for (auto& [fd, expire]: expires_) result = std::min(result, expire);
+        return result;
+    }
+
+private:
+    std::map<int, int64_t> expires_;
+};
+
+static int randomTimeout(std::mt19937& rng) {
+    // 大多数落在第 0、1 层, 少数跨越上层或超出时间轮的范围 (约 4.6 小时)
+    switch (rng() % 8) {
+        case 0: return 1 + rng() % 64;
+        case 1: return 1 + rng() % 300'000;
+        case 2: return 1 + rng() % 40'000'000;
+        default: return 1 + rng() % 5'000;
+    }
+}
+
+static int64_t randomStep(std::mt19937& rng) {
+    switch (rng() % 16) {
+        case 0: return 0;
+        case 1: return rng() % 100'000;
+        case 2: return rng() % 2'000'000;
+        default: return rng() % 200;
+    }
+}
+
+// 随机操作若干轮, 每次推进时间后比较过期的 fd 集合, 并检查 getNextTick 不会晚于最早的过期时间
+static void runRandomized(Timer& timer, unsigned seed, int rounds) {
+    std::mt19937 rng(seed);
+    ReferenceTimer model;
+    std::vector<int> expired;
+    constexpr int MAX_FD = 512;
+
+    for (int round = 0; round < rounds; ++ round) {
+        int ops = rng() % 32;
+        for (int i = 0; i < ops; ++ i) {
+            int fd = rng() % MAX_FD;
+            switch (rng() % 4) {
+                case 0: {
+                    int timeout = randomTimeout(rng);
+                    timer.addTimer(fd, timeout);
+                    model.add(fd, timeout);
+                    break;
+                }
+                case 1:
+                case 2: {
+                    int timeout = randomTimeout(rng);
+                    timer.updateTimer(fd, timeout);
+                    model.add(fd, timeout);
+                    break;
+                }
+                case 3:
+                    timer.removeTimer(fd);
+                    model.remove(fd);
+                    break;
+            }
+        }
+
+        int next = timer.getNextTick();
+        if (model.empty()) {
+            ASSERT_EQ(next, -1) << "round " << round;
+        } else {
+            ASSERT_GE(next, 0) << "round " << round;
+            ASSERT_LE(fake_now_ms + next, model.earliest()) << "round " << round;
+        }
+
+        advance(randomStep(rng));
+        expired.clear();
+        timer.tick(expired);
+        std::vector<int> expected = model.tick();
+        std::sort(expired.begin(), expired.end());
+        ASSERT_EQ(expired, expected) << "round " << round << ", seed " << seed;
+    }
+}
+
+TEST(TimingWheel, MatchesReferenceModel) {
+    for (unsigned seed = 1; seed <= 20; ++ seed) {
+        TimingWheel wheel;
+        runRandomized(wheel, seed, 1000);
+    }
+}
+
+// 按 getNextTick 返回的时间逐步推进, 模拟事件循环, 每个定时器都要在过期的那一毫秒被取出
+TEST(TimingWheel, ExpiresExactlyWhenDrivenByNextTick) {
+    std::mt19937 rng(42);
+    TimingWheel wheel;
+    ReferenceTimer model;
+    for (int fd = 0; fd < 200; ++ fd) {
+        int timeout = randomTimeout(rng);
+        wheel.addTimer(fd, timeout);
+        model.add(fd, timeout);
+    }
+    std::vector<int> expired;
+    while (!model.empty()) {
+        int next = wheel.getNextTick();
+        ASSERT_GE(next, 0);
+        ASSERT_LE(fake_now_ms + next, model.earliest());
+        advance(next);
+        expired.clear();
+        wheel.tick(expired);
+        std::sort(expired.begin(), expired.end());
+        ASSERT_EQ(expired, model.tick());
+    }
+    EXPECT_EQ(wheel.getNextTick(), -1);
+}
+
+TEST(HeapTimer, MatchesReferenceModel) {
+    for (unsigned seed = 1; seed <= 20; ++ seed) {
+        HeapTimer heap;
+        runRandomized(heap, seed, 1000);
+    }
+}
+
+// 小根堆的 getNextTick 是精确的, 等于最早的过期时间与当前时间之差
+TEST(HeapTimer, NextTickIsExact) {
+    std::mt19937 rng(7);
+    HeapTimer heap;
+    ReferenceTimer model;
+    EXPECT_EQ(heap.getNextTick(), -1);
+    for (int i = 0; i < 2000; ++ i) {
+        int fd = rng() % 256;
+        if (rng() % 4 == 0) {
+            heap.removeTimer(fd);
+            model.remove(fd);
+        } else {
+            int timeout = randomTimeout(rng);
+            heap.updateTimer(fd, timeout);
+            model.add(fd, timeout);
+        }
+        if (model.empty()) {
+            ASSERT_EQ(heap.getNextTick(), -1);
+        } else {
+            ASSERT_EQ(fake_now_ms + heap.getNextTick(), model.earliest());
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#include "cachedclock.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+// 每个线程缓存最近一次格式化的结果, 墙上时间的秒数变化时才重新格式化
+struct FormattedTime {
+    time_t log_time = -1;
+    std::string log_timestamp;
+    time_t date_time = -1;
+    std::string http_date;
+};
+
+thread_local FormattedTime tls_formatted;
+thread_local CachedClock* tls_clock = nullptr;
+
+}
+
+CachedClock& CachedClock::getInstance() {
+    return tls_clock != nullptr ? *tls_clock : global();
+}
+
+CachedClock& CachedClock::global() {
+    static CachedClock instance;
+    return instance;
+}
+
+void CachedClock::bindToThread() {
+    tls_clock = this;
+}
+
+CachedClock::CachedClock() : now_ms_(0), wall_time_ms_(0) {
+    update();
+}
+
+void CachedClock::update() {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    // 只有一个写线程, 不需要 CAS; 值没有变化时不写, 避免其他线程缓存的 cache line 失效
+    if (now == now_ms_.load(std::memory_order_relaxed)) return;
+    now_ms_.store(now, std::memory_order_relaxed);
+    int64_t wall = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    wall_time_ms_.store(wall, std::memory_order_relaxed);
+}
+
+const std::string& CachedClock::logTimestamp(time_t now) {
+    if (tls_formatted.log_time != now) {
+        char buf[32];
+        tm local{};
+        localtime_r(&now, &local);
+        size_t len = strftime(buf, sizeof(buf), "%F %T", &local);
+        tls_formatted.log_timestamp.assign(buf, len);
+        tls_formatted.log_time = now;
+    }
+    return tls_formatted.log_timestamp;
+}
+
+const std::string& CachedClock::httpDate() {
+    time_t now = wallTime();
+    if (tls_formatted.date_time != now) {
+        // 不使用 strftime 的 %a %b, 避免受 locale 影响
+        static const char* const DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        static const char* const MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        char buf[32];
+        tm gmt{};
+        gmtime_r(&now, &gmt);
+        int len = snprintf(buf, sizeof(buf), "%s, %02d %s %04d %02d:%02d:%02d GMT", DAYS[gmt.tm_wday], gmt.tm_mday,
+                           MONTHS[gmt.tm_mon], gmt.tm_year + 1900, gmt.tm_hour, gmt.tm_min, gmt.tm_sec);
+        tls_formatted.http_date.assign(buf, len);
+        tls_formatted.date_time = now;
+    }
+    return tls_formatted.http_date;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// 粗粒度缓存时钟: 事件循环每次 epoll_wait 返回后调用一次 update(), 其余地方只读取缓存的值,
+// 热路径上不再调用 clock_gettime, 格式化后的时间字符串每个线程每秒只生成一次.
+// 每个子 reactor 有自己的时钟, 只由该线程写入, 各事件循环之间不共享被频繁写入的 cache line.
+// 不运行事件循环的线程 (线程池的工作线程、日志和数据库线程) 读取全局时钟, 它由线程池模式的主循环或 0 号子 reactor 刷新
+class CachedClock {
+public:
+    CachedClock();
+    CachedClock(const CachedClock&) = delete;
+    CachedClock& operator=(const CachedClock&) = delete;
+
+    static CachedClock& getInstance();  // 当前线程绑定的时钟, 没有绑定时返回全局时钟
+    static CachedClock& global();
+    void bindToThread();  // 之后本线程的 getInstance() 返回该时钟, 在事件循环线程开始时调用
+
+    void update();  // 读取系统时钟, 刷新缓存, 只能由拥有该时钟的线程调用
+
+    int64_t nowMs() const { return now_ms_.load(std::memory_order_relaxed); }  // 单调时钟 (ms)
+    time_t wallTime() const { return wall_time_ms_.load(std::memory_order_relaxed) / 1000; }  // 墙上时间 (s)
+    int64_t wallTimeMs() const { return wall_time_ms_.load(std::memory_order_relaxed); }  // 墙上时间 (ms)
+
+    // 以下字符串在调用线程内缓存, 引用在下一次调用之前有效
+    const std::string& logTimestamp() { return logTimestamp(wallTime()); }  // 本地时间, "2025-06-24 11:58:57"
+    const std::string& logTimestamp(time_t time);  // 指定时间的日志时间戳, 供日志写线程使用
+    const std::string& httpDate();  // RFC 7231 IMF-fixdate, "Tue, 24 Jun 2025 03:58:57 GMT"
+
+private:
+    std::atomic<int64_t> now_ms_;
+    std::atomic<int64_t> wall_time_ms_;
+};
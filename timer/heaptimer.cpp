@@ -3,8 +3,25 @@
 void HeapTimer::addTimer(int client_fd, int timeout_ms) {
     std::lock_guard<std::mutex> lock(mutex_);
     int64_t expire = getTimeMs() + timeout_ms;
-    heap_.push({client_fd, expire});
-    client_fd_to_expire_[client_fd] = expire;
+    if (client_fd >= static_cast<int>(fd_to_index_.size())) {
+        fd_to_index_.resize(std::max<size_t>(client_fd + 1, fd_to_index_.size() * 2), -1);
+    }
+
+    int index = fd_to_index_[client_fd];
+    if (index != -1) {
+        // 已存在则原地调整, 超时时间通常只会变大, 因此大多数情况是下沉
+        int64_t old_expire = heap_[index].expire;
+        heap_[index].expire = expire;
+        if (expire < old_expire) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+        return;
+    }
+    heap_.push_back({client_fd, expire});
+    fd_to_index_[client_fd] = heap_.size() - 1;
+    siftUp(heap_.size() - 1);
 }
 
 void HeapTimer::updateTimer(int client_fd, int timeout_ms) {
@@ -13,37 +30,78 @@ void HeapTimer::updateTimer(int client_fd, int timeout_ms) {
 
 void HeapTimer::removeTimer(int client_fd) {
     std::lock_guard<std::mutex> lock(mutex_);
-    client_fd_to_expire_.erase(client_fd);
+    if (client_fd < 0 || client_fd >= static_cast<int>(fd_to_index_.size()) || fd_to_index_[client_fd] == -1) return;
+    removeAt(fd_to_index_[client_fd]);
 }
 
 void HeapTimer::tick(std::vector<int>& expired_fds) {
     std::lock_guard<std::mutex> lock(mutex_);
     int64_t now = getTimeMs();
 
-    while (!heap_.empty())
-    {
-        TimerNode node = heap_.top();
-        // 如果已经被移除或存在更新的/更晚的版本，则跳过
-        if (client_fd_to_expire_.count(node.client_fd) == 0 || client_fd_to_expire_[node.client_fd] != node.expire) {
-            heap_.pop();
-            continue;
-        }
-        if (node.expire > now) break;
-
-        expired_fds.push_back(node.client_fd);
-        heap_.pop();
-        client_fd_to_expire_.erase(node.client_fd);
+    while (!heap_.empty() && heap_[0].expire <= now) {
+        expired_fds.push_back(heap_[0].client_fd);
+        removeAt(0);
     }
 }
 
 int64_t HeapTimer::getTimeMs() const {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return CachedClock::getInstance().nowMs();
 }
 
 int HeapTimer::getNextTick() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (heap_.empty()) return -1;  // 无线阻塞
     int64_t now = getTimeMs();
-    int64_t expire = heap_.top().expire;
+    int64_t expire = heap_[0].expire;
     return expire > now ? (expire - now) : 0;  // 最多等待时间
-}
\ No newline at end of file
+}
+
+void HeapTimer::siftUp(size_t i) {
+    TimerNode node = heap_[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / ARITY_;
+        if (heap_[parent].expire <= node.expire) break;
+        moveTo(i, heap_[parent]);
+        i = parent;
+    }
+    moveTo(i, node);
+}
+
+void HeapTimer::siftDown(size_t i) {
+    TimerNode node = heap_[i];
+    size_t n = heap_.size();
+    while (true) {
+        size_t first = i * ARITY_ + 1;
+        if (first >= n) break;
+        // 找到最早过期的子节点
+        size_t last = std::min(first + ARITY_, n);
+        size_t child = first;
+        for (size_t c = first + 1; c < last; ++ c) {
+            if (heap_[c].expire < heap_[child].expire) child = c;
+        }
+        if (node.expire <= heap_[child].expire) break;
+        moveTo(i, heap_[child]);
+        i = child;
+    }
+    moveTo(i, node);
+}
+
+void HeapTimer::moveTo(size_t i, const TimerNode& node) {
+    heap_[i] = node;
+    fd_to_index_[node.client_fd] = static_cast<int>(i);
+}
+
+void HeapTimer::removeAt(size_t i) {
+    fd_to_index_[heap_[i].client_fd] = -1;
+    TimerNode last = heap_.back();
+    heap_.pop_back();
+    if (i == heap_.size()) return;
+    // 用最后一个节点填补空位, 再根据它与原位置的大小关系上浮或下沉
+    heap_[i] = last;
+    fd_to_index_[last.client_fd] = static_cast<int>(i);
+    if (i > 0 && heap_[(i - 1) / ARITY_].expire > last.expire) {
+        siftUp(i);
+    } else {
+        siftDown(i);
+    }
+}
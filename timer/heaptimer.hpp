@@ -1,36 +1,41 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
-#include <unordered_map>
-#include <queue>
-#include <functional>
 #include <vector>
 #include <mutex>
+#include "timer.hpp"
+#include "cachedclock.hpp"
 
 struct TimerNode {
     int client_fd;
     int64_t expire;
-    bool operator<(const TimerNode& other) const {
-        return expire > other.expire;  // 小根堆，越早过期优先级越高
-    }
 };
 
-class HeapTimer {
+// 带索引的 4 叉小根堆: 节点保存在连续数组中, 以 fd 为下标记录每个节点在堆中的位置,
+// 刷新定时器时原地上浮或下沉, 堆的大小始终等于活跃连接数
+class HeapTimer : public Timer {
 public:
     // 添加新的定时器
-    void addTimer(int client_fd, int timeout_ms);
+    void addTimer(int client_fd, int timeout_ms) override;
     // 更新已有定时器
-    void updateTimer(int client_fd, int timeout_ms);
+    void updateTimer(int client_fd, int timeout_ms) override;
     // 删除定时器
-    void removeTimer(int client_fd);
+    void removeTimer(int client_fd) override;
     // 检查所有过期的连接，并调用回调关闭
-    void tick(std::vector<int>& expired_fds);
+    void tick(std::vector<int>& expired_fds) override;
     // 获取最近一次定时器事件剩余时间
-    int getNextTick();
+    int getNextTick() override;
 private:
+    static constexpr size_t ARITY_ = 4;  // 4 叉堆层数更少, 且一个节点的子节点在同一个 cache line 中
+
     int64_t getTimeMs() const;
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void moveTo(size_t i, const TimerNode& node);  // 把节点放到位置 i 并更新索引
+    void removeAt(size_t i);
     std::mutex mutex_;
 
-    std::priority_queue<TimerNode> heap_;  // 小根堆
-    std::unordered_map<int, int64_t> client_fd_to_expire_;  // client_fd 到过期时间的映射
+    std::vector<TimerNode> heap_;  // 小根堆
+    std::vector<int> fd_to_index_;  // client_fd 在 heap_ 中的位置, -1 表示没有定时器
 };
@@ -0,0 +1,8 @@
+#include "timer.hpp"
+#include "heaptimer.hpp"
+#include "timingwheel.hpp"
+
+std::unique_ptr<Timer> createTimer(TimerType type) {
+    if (type == TimerType::WHEEL) return std::make_unique<TimingWheel>();
+    return std::make_unique<HeapTimer>();
+}
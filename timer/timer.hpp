@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+enum class TimerType {
+    HEAP,  // 小根堆
+    WHEEL  // 分层时间轮
+};
+
+// 连接超时定时器的公共接口, 以 client_fd 标识定时器
+class Timer {
+public:
+    virtual ~Timer() = default;
+
+    // 添加新的定时器
+    virtual void addTimer(int client_fd, int timeout_ms) = 0;
+    // 更新已有定时器, 不存在时添加
+    virtual void updateTimer(int client_fd, int timeout_ms) = 0;
+    // 删除定时器
+    virtual void removeTimer(int client_fd) = 0;
+    // 取出所有已过期的 client_fd
+    virtual void tick(std::vector<int>& expired_fds) = 0;
+    // 距离下一次需要调用 tick 的毫秒数, 没有定时器时返回 -1
+    virtual int getNextTick() = 0;
+};
+
+std::unique_ptr<Timer> createTimer(TimerType type);
@@ -0,0 +1,154 @@
+#include "timingwheel.hpp"
+
+#include <algorithm>
+#include <bit>
+
+TimingWheel::TimingWheel() : current_(getTimeMs()) {
+    std::fill(std::begin(heads_), std::end(heads_), -1);
+}
+
+void TimingWheel::addTimer(int client_fd, int timeout_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (client_fd >= static_cast<int>(nodes_.size())) {
+        nodes_.resize(std::max<size_t>(client_fd + 1, nodes_.size() * 2));
+    }
+    Node& node = nodes_[client_fd];
+    if (node.slot != -1) {
+        unlink(client_fd);
+    } else {
+        ++ count_;
+    }
+    // 至少在下一个 tick 才过期, 不能放进正在处理的槽
+    node.expire = std::max(getTimeMs() + timeout_ms, current_ + 1);
+    place(client_fd);
+}
+
+void TimingWheel::updateTimer(int client_fd, int timeout_ms) {
+    addTimer(client_fd, timeout_ms);
+}
+
+void TimingWheel::removeTimer(int client_fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (client_fd < 0 || client_fd >= static_cast<int>(nodes_.size()) || nodes_[client_fd].slot == -1) return;
+    unlink(client_fd);
+    -- count_;
+}
+
+void TimingWheel::tick(std::vector<int>& expired_fds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = getTimeMs();
+    while (current_ < now) {
+        if (count_ == 0) {
+            current_ = now;
+            break;
+        }
+        // 直接跳到第 0 层下一个非空槽, 但不能越过下一次需要从上层降级的时刻
+        int64_t boundary = (current_ | MASK_) + 1;
+        int64_t next = boundary;
+        int pos = static_cast<int>(current_ & MASK_);
+        uint64_t bits = std::rotr(occupied_[0], (pos + 1) & MASK_);
+        if (bits != 0) next = std::min(next, current_ + 1 + std::countr_zero(bits));
+        if (next > now) {
+            current_ = now;
+            break;
+        }
+        current_ = next - 1;
+        step(expired_fds);
+    }
+}
+
+int TimingWheel::getNextTick() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == 0) return -1;
+    // 每层找到下一个非空槽, 第 0 层是它的过期时间, 上层是它需要降级的时间, 取最早的一个
+    int64_t earliest = INT64_MAX;
+    for (int level = 0; level < LEVELS_; ++ level) {
+        if (occupied_[level] == 0) continue;
+        int shift = level * SLOT_BITS_;
+        int64_t block = current_ >> shift;
+        uint64_t bits = std::rotr(occupied_[level], (block + 1) & MASK_);
+        earliest = std::min(earliest, (block + 1 + std::countr_zero(bits)) << shift);
+    }
+    int64_t now = getTimeMs();
+    return earliest > now ? static_cast<int>(std::min<int64_t>(earliest - now, INT32_MAX)) : 0;
+}
+
+int64_t TimingWheel::getTimeMs() const {
+    return CachedClock::getInstance().nowMs();
+}
+
+void TimingWheel::place(int fd) {
+    int64_t expire = nodes_[fd].expire;
+    int64_t delta = expire - current_;
+    if (delta > MAX_DELTA_) {
+        // 超出时间轮范围, 先放在最远的位置, 降级时重新计算
+        expire = current_ + MAX_DELTA_;
+        delta = MAX_DELTA_;
+    }
+    if (delta < 0) expire = current_;  // 降级时已到期, 放进当前槽立即处理
+
+    int level = 0;
+    while (level < LEVELS_ - 1 && delta >= (int64_t(1) << (SLOT_BITS_ * (level + 1)))) ++ level;
+    int index = static_cast<int>((expire >> (SLOT_BITS_ * level)) & MASK_);
+    link(fd, level * SLOTS_ + index);
+}
+
+void TimingWheel::link(int fd, int slot) {
+    Node& node = nodes_[fd];
+    node.slot = slot;
+    node.prev = -1;
+    node.next = heads_[slot];
+    if (node.next != -1) nodes_[node.next].prev = fd;
+    heads_[slot] = fd;
+    occupied_[slot / SLOTS_] |= uint64_t(1) << (slot % SLOTS_);
+}
+
+void TimingWheel::unlink(int fd) {
+    Node& node = nodes_[fd];
+    if (node.prev != -1) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.slot] = node.next;
+        if (node.next == -1) occupied_[node.slot / SLOTS_] &= ~(uint64_t(1) << (node.slot % SLOTS_));
+    }
+    if (node.next != -1) nodes_[node.next].prev = node.prev;
+    node.prev = node.next = node.slot = -1;
+}
+
+void TimingWheel::cascade(int level) {
+    int index = static_cast<int>((current_ >> (SLOT_BITS_ * level)) & MASK_);
+    // 本层转完一圈时, 先把更上一层的槽降到本层
+    if (index == 0 && level + 1 < LEVELS_) cascade(level + 1);
+
+    int slot = level * SLOTS_ + index;
+    int fd = heads_[slot];
+    heads_[slot] = -1;
+    occupied_[level] &= ~(uint64_t(1) << index);
+    while (fd != -1) {
+        int next = nodes_[fd].next;
+        place(fd);
+        fd = next;
+    }
+}
+
+void TimingWheel::step(std::vector<int>& expired_fds) {
+    ++ current_;
+    if ((current_ & MASK_) == 0) cascade(1);
+
+    int slot = static_cast<int>(current_ & MASK_);
+    int fd = heads_[slot];
+    heads_[slot] = -1;
+    occupied_[0] &= ~(uint64_t(1) << slot);
+    while (fd != -1) {
+        Node& node = nodes_[fd];
+        int next = node.next;
+        if (node.expire <= current_) {
+            node.prev = node.next = node.slot = -1;
+            -- count_;
+            expired_fds.push_back(fd);
+        } else {
+            place(fd);  // 超出范围而被提前放置的节点
+        }
+        fd = next;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "timer.hpp"
+#include "cachedclock.hpp"
+
+// 分层时间轮: 4 层, 每层 64 个槽, 精度 1 ms, 最远可表示约 4.6 小时.
+// 每个连接的节点直接存放在以 fd 为下标的数组中, 通过下标串成双向链表,
+// 添加、刷新、删除都是 O(1), 刷新时只移动节点, 不会留下过期的副本
+class TimingWheel : public Timer {
+public:
+    TimingWheel();
+
+    void addTimer(int client_fd, int timeout_ms) override;
+    void updateTimer(int client_fd, int timeout_ms) override;
+    void removeTimer(int client_fd) override;
+    void tick(std::vector<int>& expired_fds) override;
+    int getNextTick() override;
+
+private:
+    static constexpr int LEVELS_ = 4;
+    static constexpr int SLOT_BITS_ = 6;
+    static constexpr int SLOTS_ = 1 << SLOT_BITS_;
+    static constexpr int64_t MASK_ = SLOTS_ - 1;
+    static constexpr int64_t MAX_DELTA_ = (int64_t(1) << (SLOT_BITS_ * LEVELS_)) - 1;
+
+    struct Node {
+        int prev = -1;
+        int next = -1;
+        int slot = -1;  // 所在槽的全局编号 level * SLOTS_ + index, -1 表示不在时间轮中
+        int64_t expire = 0;
+    };
+
+    int64_t getTimeMs() const;
+    void place(int fd);  // 根据 expire 与 current_ 的差值把节点放入对应层的槽
+    void link(int fd, int slot);
+    void unlink(int fd);
+    void cascade(int level);  // 把上层一个槽中的节点重新分配到下层
+    void step(std::vector<int>& expired_fds);  // 前进 1 ms 并处理第 0 层的当前槽
+
+    std::mutex mutex_;
+    int64_t current_;  // 时间轮已经处理到的时间 (ms)
+    size_t count_ = 0;
+    std::vector<Node> nodes_;  // 以 fd 为下标
+    int heads_[LEVELS_ * SLOTS_];
+    uint64_t occupied_[LEVELS_] = {};  // 每层非空槽的位图, 用于跳过空槽
+};
@@ -0,0 +1,125 @@
+// 把二进制访问日志转换为文本或 CSV
+//   ./access_log_decode access.log          # 文本, 每行一条
+//   ./access_log_decode -c access.log       # CSV
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../log/access_log_format.hpp"
+
+static void formatTime(int64_t time_ms, char* buf, size_t size) {
+    time_t seconds = time_ms / 1000;
+    tm local{};
+    localtime_r(&seconds, &local);
+    size_t len = strftime(buf, size, "%F %T", &local);
+    snprintf(buf + len, size - len, ".%03d", static_cast<int>(time_ms % 1000));
+}
+
+// CSV 字段中包含逗号、引号或换行时加引号
+static std::string csvField(const std::string& s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string out = "\"";
+    for (char c: s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+int main(int argc, char* argv[]) {
+    bool csv = false;
+    const char* filename = nullptr;
+    for (int i = 1; i < argc; ++ i) {
+        if (strcmp(argv[i], "-c") == 0) {
+            csv = true;
+        } else {
+            filename = argv[i];
+        }
+    }
+    if (filename == nullptr) {
+        fprintf(stderr, "Usage: %s [-c] access.log\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", filename);
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (csv) printf("time,fd,method,path,status,bytes,latency_us\n");
+
+    std::vector<std::string> paths(1);  // 下标为路径编号, 0 表示未驻留
+    int64_t time_ms = 0;
+    size_t entries = 0;
+    const char* p = data.data();
+    const char* end = p + data.size();
+    while (p < end) {
+        // 段头: 重置路径表和时间基准
+        if (end - p >= 5 && memcmp(p, AccessLogFormat::MAGIC, sizeof(AccessLogFormat::MAGIC)) == 0) {
+            if (static_cast<uint8_t>(p[4]) != AccessLogFormat::VERSION) {
+                fprintf(stderr, "Unsupported version %d at offset %zu\n", p[4], static_cast<size_t>(p - data.data()));
+                return 1;
+            }
+            p += 5;
+            paths.assign(1, "");
+            time_ms = 0;
+            continue;
+        }
+
+        uint8_t tag = static_cast<uint8_t>(*p ++);
+        uint64_t id, len, delta, fd, path_id, status, bytes, latency;
+        bool ok = true;
+        if (tag == AccessLogFormat::TAG_PATH) {
+            // 编号按顺序分配, 其他值说明文件已损坏, 不能按它扩大路径表
+            ok = AccessLogFormat::getVarint(p, end, id) && id == paths.size() && AccessLogFormat::getVarint(p, end, len) &&
+                 static_cast<uint64_t>(end - p) >= len;
+            if (ok) {
+                paths.emplace_back(p, len);
+                p += len;
+            }
+        } else if (tag == AccessLogFormat::TAG_ENTRY) {
+            std::string path;
+            ok = AccessLogFormat::getVarint(p, end, delta) && AccessLogFormat::getVarint(p, end, fd) && p < end;
+            uint8_t method = ok ? static_cast<uint8_t>(*p ++) : 0;
+            ok = ok && AccessLogFormat::getVarint(p, end, path_id);
+            if (ok && path_id == 0) {
+                ok = AccessLogFormat::getVarint(p, end, len) && static_cast<uint64_t>(end - p) >= len;
+                if (ok) {
+                    path.assign(p, len);
+                    p += len;
+                }
+            } else if (ok) {
+                path = path_id < paths.size() ? paths[path_id] : "?";
+            }
+            ok = ok && AccessLogFormat::getVarint(p, end, status) && AccessLogFormat::getVarint(p, end, bytes) &&
+                 AccessLogFormat::getVarint(p, end, latency);
+            if (ok) {
+                time_ms += AccessLogFormat::unzigzag(delta);
+                const char* method_name = AccessLogFormat::METHOD_NAMES[method <= AccessLogFormat::OTHER ? method : static_cast<uint8_t>(AccessLogFormat::OTHER)];
+                if (path.empty()) path = "-";
+                char time_buf[40];
+                formatTime(time_ms, time_buf, sizeof(time_buf));
+                if (csv) {
+                    printf("%s,%llu,%s,%s,%llu,%llu,%llu\n", time_buf, (unsigned long long)fd, method_name, csvField(path).c_str(),
+                           (unsigned long long)status, (unsigned long long)bytes, (unsigned long long)latency);
+                } else {
+                    printf("%s fd=%llu %s %s %llu %llu bytes %llu us\n", time_buf, (unsigned long long)fd, method_name, path.c_str(),
+                           (unsigned long long)status, (unsigned long long)bytes, (unsigned long long)latency);
+                }
+                ++ entries;
+            }
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "Corrupted record at offset %zu, stopped after %zu entries\n", static_cast<size_t>(p - data.data()), entries);
+            return 1;
+        }
+    }
+    return 0;
+}